@@ -29,6 +29,25 @@ typedef enum SDLx_ModelType
     SDLX_MODELTYPE_COUNT,
 } SDLx_ModelType;
 
+typedef Uint32 SDLx_ModelFlags;
+
+#define SDLX_MODELFLAG_INTERLEAVE (1u << 0) /* glTF: one vertex buffer per primitive, see SDLx_ModelVertexLayout */
+#define SDLX_MODELFLAG_PACK       (1u << 1) /* glTF: one vertex and one index buffer per model */
+#define SDLX_MODELFLAG_MIPMAPS    (1u << 2) /* glTF: full mip chain, box filtered on the decode threads */
+#define SDLX_MODELFLAG_CACHE      (1u << 3) /* read or write <path>.sdlxm, see README */
+#define SDLX_MODELFLAG_GREEDY     (1u << 4) /* vox: SDLX_MODELTYPE_VOXOBJ greedy meshed from the .vox alone */
+#define SDLX_MODELFLAG_CULL       (1u << 5) /* vox: SDLX_MODELTYPE_VOXRAW drops voxels enclosed on all six sides */
+#define SDLX_MODELFLAG_OCTREE     (1u << 6) /* vox: SDLX_MODELTYPE_VOXRAW builds an SDLx_ModelVoxOctree per shape */
+#define SDLX_MODELFLAG_LODS       (1u << 7) /* glTF: simplified index ranges per primitive, see README */
+#define SDLX_MODELFLAG_MESHLETS   (1u << 8) /* glTF: meshlets with culling bounds per primitive, see README */
+#define SDLX_MODELFLAG_OPTIMIZE   (1u << 9) /* glTF, vox obj: reorder indices and vertices for the GPU, see README */
+#define SDLX_MODELFLAG_QUANTIZE   (1u << 10) /* glTF: 16 bit vertex attributes, see README */
+#define SDLX_MODELFLAG_UNORM_TEXCOORDS (1u << 11) /* glTF: with SDLX_MODELFLAG_QUANTIZE, USHORT2_NORM texcoords instead of HALF2 */
+
+#define SDLX_MODEL_MAX_LODS 4
+#define SDLX_MODEL_MAX_MESHLET_VERTICES 64
+#define SDLX_MODEL_MAX_MESHLET_TRIANGLES 124
+
 typedef struct SDLx_ModelVec2
 {
     float x;
@@ -44,16 +63,97 @@ typedef struct SDLx_ModelVec3
 
 typedef float SDLx_ModelMatrix[16];
 
+typedef struct SDLx_ModelGltfVertex
+{
+    SDLx_ModelVec3 position;
+    SDLx_ModelVec2 texcoord;
+    SDLx_ModelVec3 normal;
+} SDLx_ModelGltfVertex;
+
+/* position is SHORT4_NORM, texcoord HALF2 or USHORT2_NORM and normal SHORT2_NORM */
+typedef struct SDLx_ModelGltfQuantizedVertex
+{
+    Sint16 position[4];
+    Uint16 texcoord[2];
+    Sint16 normal[2];
+} SDLx_ModelGltfQuantizedVertex;
+
+/*
+ * Describes the vertex buffer(s) of every primitive in a model. With a zero
+ * stride each attribute has a tightly packed buffer of its own.
+ */
+typedef struct SDLx_ModelVertexLayout
+{
+    Uint32 stride;
+    Uint32 position_offset;
+    Uint32 texcoord_offset;
+    Uint32 normal_offset;
+    SDL_GPUVertexElementFormat position_format;
+    SDL_GPUVertexElementFormat texcoord_format;
+    SDL_GPUVertexElementFormat normal_format;
+} SDLx_ModelVertexLayout;
+
+/*
+ * A level of detail of a primitive, drawn with the primitive's vertices.
+ * error is the distance in model units the simplified surface may be off
+ * by, zero for the full resolution level.
+ */
+typedef struct SDLx_ModelLod
+{
+    Uint32 first_index;
+    Uint32 num_indices;
+    float error;
+} SDLx_ModelLod;
+
+/*
+ * A cluster of the full resolution level of a primitive. Its triangles are
+ * num_triangles Uint32s from first_triangle, each packing three local
+ * indices as a | b << 8 | c << 16 into the num_vertices Uint32s from
+ * first_vertex, which index the primitive's vertices. Laid out for std430.
+ * The whole meshlet faces away from the camera, and may be culled, when
+ * dot(normalize(cone_apex - camera), cone_axis) >= cone_cutoff.
+ */
+typedef struct SDLx_ModelMeshlet
+{
+    Uint32 first_vertex;
+    Uint32 first_triangle;
+    Uint32 num_vertices;
+    Uint32 num_triangles;
+    SDLx_ModelVec3 center;
+    float radius;
+    SDLx_ModelVec3 cone_apex;
+    float cone_cutoff;        /* 1 when the triangles face too many ways to cull */
+    SDLx_ModelVec3 cone_axis;
+    float padding;
+} SDLx_ModelMeshlet;
+
 typedef struct SDLx_ModelPrimitive
 {
-    SDL_GPUBuffer* position_buffer; /* SDLx_ModelVec3 */
-    SDL_GPUBuffer* texcoord_buffer; /* SDLx_ModelVec2 */
-    SDL_GPUBuffer* normal_buffer;   /* SDLx_ModelVec3 */
+    SDL_GPUBuffer* vertex_buffer;   /* SDLx_ModelGltfVertex or SDLx_ModelGltfQuantizedVertex, if SDLX_MODELFLAG_INTERLEAVE */
+    SDL_GPUBuffer* position_buffer; /* SDLx_ModelVec3, or as in the layout */
+    SDL_GPUBuffer* texcoord_buffer; /* SDLx_ModelVec2, or as in the layout */
+    SDL_GPUBuffer* normal_buffer;   /* SDLx_ModelVec3, or as in the layout */
     SDL_GPUBuffer* index_buffer;    /* Uint16 or Uint32 */
     SDL_GPUTexture* color_texture;
     SDL_GPUTexture* normal_texture;
-    Uint16 num_indices;
+    Uint32 position_buffer_offset;  /* binding offsets, non-zero with SDLX_MODELFLAG_PACK */
+    Uint32 texcoord_buffer_offset;
+    Uint32 normal_buffer_offset;
+    Uint32 first_index;
+    Sint32 vertex_offset;
+    Uint32 num_indices;
     SDL_GPUIndexElementSize index_element_size;
+    SDLx_ModelLod lods[SDLX_MODEL_MAX_LODS]; /* from fine to coarse, if SDLX_MODELFLAG_LODS */
+    int num_lods;
+    SDL_GPUBuffer* meshlet_buffer;          /* SDLx_ModelMeshlet, if SDLX_MODELFLAG_MESHLETS */
+    SDL_GPUBuffer* meshlet_vertex_buffer;   /* Uint32 */
+    SDL_GPUBuffer* meshlet_triangle_buffer; /* Uint32 */
+    const SDLx_ModelMeshlet* meshlets;      /* CPU copy of meshlet_buffer from first_meshlet */
+    Uint32 first_meshlet;                   /* non-zero with SDLX_MODELFLAG_PACK */
+    Uint32 num_meshlets;
+    SDLx_ModelMatrix position_transform;  /* quantized to model space, identity without SDLX_MODELFLAG_QUANTIZE */
+    SDLx_ModelVec2 texcoord_scale;        /* texcoord = quantized * scale + bias */
+    SDLx_ModelVec2 texcoord_bias;
 } SDLx_ModelPrimitive;
 
 typedef struct SDLx_ModelMesh
@@ -74,6 +174,7 @@ typedef struct SDLx_ModelGltf
     int num_meshes;
     SDLx_ModelNode* nodes;
     int num_nodes;
+    SDLx_ModelVertexLayout layout;
 } SDLx_ModelGltf;
 
 /*
@@ -95,7 +196,7 @@ typedef struct SDLx_ModelVoxObj
     SDL_GPUBuffer* vertex_buffer;    /* SDLx_ModelVoxObjVertex */
     SDL_GPUBuffer* index_buffer;     /* Uint16 or Uint32 */
     SDL_GPUTexture* palette_texture;
-    Uint16 num_indices;
+    Uint32 num_indices;
     SDL_GPUIndexElementSize index_element_size;
 } SDLx_ModelVoxObj;
 
@@ -112,6 +213,65 @@ typedef struct SDLx_ModelVoxRawInstance
     Uint32 color;
 } SDLx_ModelVoxRawInstance;
 
+/*
+ * One model of a .vox file, a range of the instance buffer. Draw it with
+ * first_instance and num_instances.
+ */
+typedef struct SDLx_ModelVoxRawShape
+{
+    Uint32 first_instance;
+    Uint32 num_instances;
+} SDLx_ModelVoxRawShape;
+
+typedef struct SDLx_ModelVoxRawNode
+{
+    SDLx_ModelVoxRawShape* shape;
+    SDLx_ModelMatrix transform;
+} SDLx_ModelVoxRawNode;
+
+typedef struct SDLx_ModelVoxOctreeNode
+{
+    Uint32 first_child; /* into nodes, or bricks below the last level */
+    Uint8 child_mask;   /* bit x | y << 1 | z << 2, children are stored for set bits only */
+    Uint8 padding[3];
+} SDLx_ModelVoxOctreeNode;
+
+typedef struct SDLx_ModelVoxOctreeBrick
+{
+    Uint64 mask;                /* bit i set when palette_indices[i] is non-zero */
+    Uint8 palette_indices[64];  /* x | y << 2 | z << 4 */
+} SDLx_ModelVoxOctreeBrick;
+
+/*
+ * Sparse voxel octree over the voxels of one shape, in the z up coordinates
+ * of the .vox model. Nodes are stored breadth first from the root in
+ * nodes[0] and depth levels of nodes cover a cube of 4 << depth voxels,
+ * ending in 4x4x4 bricks. An instance of a shape sits at
+ * (x - size_x / 2, z - size_z / 2, size_y / 2 - y - 1).
+ */
+typedef struct SDLx_ModelVoxOctree
+{
+    SDLx_ModelVoxOctreeNode* nodes;
+    SDLx_ModelVoxOctreeBrick* bricks;
+    Uint32 num_nodes;
+    Uint32 num_bricks;
+    int depth;
+    int size;
+} SDLx_ModelVoxOctree;
+
+typedef struct SDLx_ModelVoxelHit
+{
+    int x;
+    int y;
+    int z;
+    Uint8 palette_index;
+    float distance;        /* in lengths of the ray direction */
+    SDLx_ModelVec3 normal; /* of the face entered, zero when starting inside */
+} SDLx_ModelVoxelHit;
+
+/* return false to stop iterating */
+typedef bool (SDLCALL *SDLx_ModelVoxelCallback)(void* userdata, int x, int y, int z, Uint8 palette_index);
+
 typedef struct SDLx_ModelVoxRaw
 {
     SDL_GPUBuffer* vertex_buffer;   /* SDLx_ModelVec3 */
@@ -120,6 +280,11 @@ typedef struct SDLx_ModelVoxRaw
     Uint16 num_indices;
     Uint32 num_instances;
     SDL_GPUIndexElementSize index_element_size;
+    SDLx_ModelVoxRawShape* shapes;
+    int num_shapes;
+    SDLx_ModelVoxRawNode* nodes;    /* one per shape reference of the scene graph */
+    int num_nodes;
+    SDLx_ModelVoxOctree* octrees;   /* one per shape, if SDLX_MODELFLAG_OCTREE */
 } SDLx_ModelVoxRaw;
 
 typedef struct SDLx_Model
@@ -135,5 +300,150 @@ typedef struct SDLx_Model
     SDLx_ModelVec3 max;
 } SDLx_Model;
 
+typedef struct SDLx_ModelImage
+{
+    void* pixels; /* levels stored back to back */
+    int width;
+    int height;
+    int num_levels;
+    SDL_GPUTextureFormat format; /* R8G8B8A8_UNORM unless loaded from KTX2 */
+    const char* key;             /* shares the texture between models of a device, NULL for a private texture */
+} SDLx_ModelImage;
+
+typedef struct SDLx_ModelPrimitiveData
+{
+    SDLx_ModelVec3* positions;
+    SDLx_ModelVec2* texcoords;
+    SDLx_ModelVec3* normals;
+    void* indices;              /* Uint16 or Uint32, every level back to back */
+    Uint32 num_vertices;
+    Uint32 num_indices;
+    SDL_GPUIndexElementSize index_element_size;
+    int color_image;            /* index into images or -1 */
+    int normal_image;           /* index into images or -1 */
+    SDLx_ModelLod lods[SDLX_MODEL_MAX_LODS];
+    int num_lods;
+    SDLx_ModelMeshlet* meshlets;
+    Uint32* meshlet_vertices;
+    Uint32* meshlet_triangles;
+    Uint32 num_meshlets;
+    Uint32 num_meshlet_vertices;
+    Uint32 num_meshlet_triangles;
+} SDLx_ModelPrimitiveData;
+
+typedef struct SDLx_ModelMeshData
+{
+    SDLx_ModelPrimitiveData* primitives;
+    int num_primitives;
+} SDLx_ModelMeshData;
+
+typedef struct SDLx_ModelNodeData
+{
+    int mesh; /* index into meshes */
+    SDLx_ModelMatrix transform;
+} SDLx_ModelNodeData;
+
+typedef struct SDLx_ModelGltfData
+{
+    SDLx_ModelMeshData* meshes;
+    int num_meshes;
+    SDLx_ModelNodeData* nodes;
+    int num_nodes;
+    SDLx_ModelImage* images;
+    int num_images;
+} SDLx_ModelGltfData;
+
+typedef struct SDLx_ModelVoxObjData
+{
+    SDLx_ModelVoxObjVertex* vertices;
+    void* indices;              /* Uint16 or Uint32 */
+    Uint32 num_vertices;
+    Uint32 num_indices;
+    SDL_GPUIndexElementSize index_element_size;
+    SDLx_ModelImage palette;
+} SDLx_ModelVoxObjData;
+
+typedef struct SDLx_ModelVoxRawNodeData
+{
+    int shape; /* index into shapes */
+    SDLx_ModelMatrix transform;
+} SDLx_ModelVoxRawNodeData;
+
+typedef struct SDLx_ModelVoxRawData
+{
+    SDLx_ModelVoxRawInstance* instances;
+    Uint32 num_instances;
+    SDLx_ModelVoxRawShape* shapes;
+    int num_shapes;
+    SDLx_ModelVoxRawNodeData* nodes;
+    int num_nodes;
+    SDLx_ModelVoxOctree* octrees; /* one per shape, if SDLX_MODELFLAG_OCTREE */
+} SDLx_ModelVoxRawData;
+
+/*
+ * Post-transform vertex cache efficiency of the indices of a model, with a
+ * 16 entry FIFO cache. acmr is the vertices shaded per triangle, 3 at worst,
+ * and atvr per referenced vertex, 1 at best.
+ */
+typedef struct SDLx_ModelIndexStats
+{
+    float acmr;
+    float atvr;
+} SDLx_ModelIndexStats;
+
+/*
+ * CPU-side result of SDLx_ModelDecode. Holds no GPU resources and may be
+ * created on any thread.
+ */
+typedef struct SDLx_ModelData
+{
+    SDLx_ModelType type;
+    SDLx_ModelFlags flags;
+    union
+    {
+        SDLx_ModelGltfData gltf;
+        SDLx_ModelVoxObjData vox_obj;
+        SDLx_ModelVoxRawData vox_raw;
+    };
+    SDLx_ModelVec3 min;
+    SDLx_ModelVec3 max;
+    SDLx_ModelIndexStats source_index_stats; /* before and after SDLX_MODELFLAG_OPTIMIZE */
+    SDLx_ModelIndexStats index_stats;
+} SDLx_ModelData;
+
+/*
+ * Handle for a model loaded with SDLx_ModelLoadAsync. Decoding and staging
+ * run on a background thread. Once SDLx_ModelUploadAsync returns true, pass
+ * the fence of the submitted command buffer to SDLx_ModelFenceAsync and
+ * finish with SDLx_ModelWait. SDLx_ModelIsReady reports true once that fence
+ * has signaled, or as soon as decoding fails.
+ */
+typedef struct SDLx_ModelAsync SDLx_ModelAsync;
+
+/*
+ * Owns a growable ring of transfer buffers that are reused across loads.
+ * Models created through it are usable once SDLx_ModelSubmitUploader has
+ * submitted their uploads, and must not be destroyed before then. When the
+ * submit fails, the uploads stay queued for the next call. Not thread safe.
+ */
+typedef struct SDLx_ModelUploader SDLx_ModelUploader;
+
 SDLX_MODEL_API SDLx_Model* SDLx_ModelLoad(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const char* path, SDLx_ModelType type);
-SDLX_MODEL_API void SDLx_ModelDestroy(SDL_GPUDevice* device, SDLx_Model* model);
\ No newline at end of file
+SDLX_MODEL_API SDLx_Model* SDLx_ModelLoadWithFlags(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags);
+SDLX_MODEL_API void SDLx_ModelDestroy(SDL_GPUDevice* device, SDLx_Model* model);
+SDLX_MODEL_API SDLx_ModelData* SDLx_ModelDecode(const char* path, SDLx_ModelType type, SDLx_ModelFlags flags);
+SDLX_MODEL_API SDLx_Model* SDLx_ModelUpload(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const SDLx_ModelData* data);
+SDLX_MODEL_API void SDLx_ModelDestroyData(SDLx_ModelData* data);
+SDLX_MODEL_API SDLx_ModelAsync* SDLx_ModelLoadAsync(SDL_GPUDevice* device, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags);
+SDLX_MODEL_API bool SDLx_ModelUploadAsync(SDLx_ModelAsync* async, SDL_GPUCopyPass* copy_pass);
+SDLX_MODEL_API void SDLx_ModelFenceAsync(SDLx_ModelAsync* async, SDL_GPUFence* fence);
+SDLX_MODEL_API bool SDLx_ModelIsReady(SDLx_ModelAsync* async);
+SDLX_MODEL_API SDLx_Model* SDLx_ModelWait(SDLx_ModelAsync* async);
+SDLX_MODEL_API SDLx_ModelUploader* SDLx_ModelCreateUploader(SDL_GPUDevice* device, Uint32 block_size);
+SDLX_MODEL_API SDLx_Model* SDLx_ModelLoadQueued(SDLx_ModelUploader* uploader, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags);
+SDLX_MODEL_API SDLx_Model* SDLx_ModelUploadQueued(SDLx_ModelUploader* uploader, const SDLx_ModelData* data);
+SDLX_MODEL_API bool SDLx_ModelSubmitUploader(SDLx_ModelUploader* uploader);
+SDLX_MODEL_API void SDLx_ModelDestroyUploader(SDLx_ModelUploader* uploader);
+SDLX_MODEL_API Uint8 SDLx_ModelGetVoxel(const SDLx_ModelVoxOctree* octree, int x, int y, int z);
+SDLX_MODEL_API bool SDLx_ModelIterateVoxels(const SDLx_ModelVoxOctree* octree, const int min[3], const int max[3], SDLx_ModelVoxelCallback callback, void* userdata);
+SDLX_MODEL_API bool SDLx_ModelRaycastVoxels(const SDLx_ModelVoxOctree* octree, SDLx_ModelVec3 origin, SDLx_ModelVec3 direction, float max_distance, SDLx_ModelVoxelHit* hit);
\ No newline at end of file
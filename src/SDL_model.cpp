@@ -3,10 +3,16 @@
 
 #include <filesystem>
 #include <limits>
+#include <span>
 
 #include "internal.hpp"
 
 SDLx_Model* SDLx_ModelLoad(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const char* path, SDLx_ModelType type)
+{
+    return SDLx_ModelLoadWithFlags(device, copy_pass, path, type, 0);
+}
+
+SDLx_Model* SDLx_ModelLoadWithFlags(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags)
 {
     if (!device)
     {
@@ -18,73 +24,245 @@ SDLx_Model* SDLx_ModelLoad(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, co
         SDL_InvalidParamError("copy_pass");
         return nullptr;
     }
-    if (!path)
+    SDLx_ModelData* data = DecodeModel(device, path, type, flags);
+    if (!data)
     {
-        SDL_InvalidParamError("path");
         return nullptr;
     }
-    std::filesystem::path file = path;
-    if (type == SDLX_MODELTYPE_INVALID)
+    SDLx_Model* model = SDLx_ModelUpload(device, copy_pass, data);
+    SDLx_ModelDestroyData(data);
+    return model;
+}
+
+SDLx_ModelData* SDLx_ModelDecode(const char* path, SDLx_ModelType type, SDLx_ModelFlags flags)
+{
+    return DecodeModel(nullptr, path, type, flags);
+}
+
+static bool DeduceType(std::filesystem::path& file, SDLx_ModelType& type, SDLx_ModelFlags flags)
+{
+    if (std::filesystem::exists(file.replace_extension(".gltf")) ||
+        std::filesystem::exists(file.replace_extension(".glb")))
+    {
+        type = SDLX_MODELTYPE_GLTF;
+    }
+    else if (std::filesystem::exists(file.replace_extension(".vox")))
     {
-        if (std::filesystem::exists(file.replace_extension(".gltf")) ||
-            std::filesystem::exists(file.replace_extension(".glb")))
+        if (flags & SDLX_MODELFLAG_GREEDY)
         {
-            type = SDLX_MODELTYPE_GLTF;
+            type = SDLX_MODELTYPE_VOXOBJ;
         }
-        else if (std::filesystem::exists(file.replace_extension(".vox")))
+        else if (std::filesystem::exists(file.replace_extension(".obj")) &&
+            std::filesystem::exists(file.replace_extension(".png")) &&
+            std::filesystem::exists(file.replace_extension(".mtl")))
         {
-            if (std::filesystem::exists(file.replace_extension(".obj")) &&
-                std::filesystem::exists(file.replace_extension(".png")) &&
-                std::filesystem::exists(file.replace_extension(".mtl")))
-            {
-                type = SDLX_MODELTYPE_VOXOBJ;
-            }
-            else
-            {
-                type = SDLX_MODELTYPE_VOXRAW;
-            }
+            type = SDLX_MODELTYPE_VOXOBJ;
         }
         else
         {
-            SDL_Log("Failed to deduce type: %s", path);
+            type = SDLX_MODELTYPE_VOXRAW;
+        }
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+static bool HashSources(Data* data, std::filesystem::path file, SDLx_ModelType type, SDLx_ModelFlags flags, uint64_t& hash)
+{
+    static const char* VoxObjSources[] = {".obj", ".mtl", ".png"};
+    static const char* VoxRawSources[] = {".vox"};
+    std::span<const char* const> sources;
+    switch (type)
+    {
+    case SDLX_MODELTYPE_GLTF:
+        return HashGltf(data, file, hash);
+    case SDLX_MODELTYPE_VOXOBJ:
+        if (flags & SDLX_MODELFLAG_GREEDY)
+        {
+            sources = VoxRawSources;
+        }
+        else
+        {
+            sources = VoxObjSources;
+        }
+        break;
+    case SDLX_MODELTYPE_VOXRAW:
+        sources = VoxRawSources;
+        break;
+    }
+    hash = 0;
+    for (const char* source : sources)
+    {
+        std::span<const uint8_t> bytes = MapFile(data, file.replace_extension(source));
+        if (bytes.empty())
+        {
+            return false;
+        }
+        hash = Hash(hash, bytes);
+    }
+    return true;
+}
+
+static Data* CreateData(SDL_GPUDevice* device, SDLx_ModelFlags flags)
+{
+    Data* data = new Data();
+    if (!data)
+    {
+        return nullptr;
+    }
+    data->device = device;
+    data->flags = flags;
+    data->min.x = std::numeric_limits<float>::max();
+    data->min.y = std::numeric_limits<float>::max();
+    data->min.z = std::numeric_limits<float>::max();
+    data->max.x = std::numeric_limits<float>::lowest();
+    data->max.y = std::numeric_limits<float>::lowest();
+    data->max.z = std::numeric_limits<float>::lowest();
+    return data;
+}
+
+Data* DecodeModel(SDL_GPUDevice* device, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags)
+{
+    if (!path)
+    {
+        SDL_InvalidParamError("path");
+        return nullptr;
+    }
+    std::filesystem::path file = path;
+    std::filesystem::path cache_file = path;
+    cache_file.replace_extension(".sdlxm");
+    bool has_type = type != SDLX_MODELTYPE_INVALID || DeduceType(file, type, flags);
+    if (!has_type && !((flags & SDLX_MODELFLAG_CACHE) && std::filesystem::exists(cache_file)))
+    {
+        SDL_Log("Failed to deduce type: %s", path);
+        return nullptr;
+    }
+    Data* data = CreateData(device, flags);
+    if (!data)
+    {
+        SDL_SetError("Failed to allocate data: %s", path);
+        return nullptr;
+    }
+    uint64_t source_hash = 0;
+    bool has_sources = has_type && (flags & SDLX_MODELFLAG_CACHE) && HashSources(data, file, type, flags, source_hash);
+    if (flags & SDLX_MODELFLAG_CACHE)
+    {
+        /* without sources, as in a shipped build, the cache is trusted as is */
+        if (ReadCache(data, cache_file, type, has_sources ? &source_hash : nullptr))
+        {
+            return data;
+        }
+        delete data;
+        data = CreateData(device, flags);
+        if (!data || !has_type)
+        {
+            SDL_Log("Failed to read cache: %s", cache_file.string().data());
+            delete data;
             return nullptr;
         }
     }
-    SDLx_Model* model = new SDLx_Model();
+    bool success = false;
+    switch (type)
+    {
+    case SDLX_MODELTYPE_GLTF:
+        success = DecodeGltf(data, file);
+        break;
+    case SDLX_MODELTYPE_VOXOBJ:
+        success = (flags & SDLX_MODELFLAG_GREEDY) ? DecodeVoxGreedy(data, file) : DecodeVoxObj(data, file);
+        break;
+    case SDLX_MODELTYPE_VOXRAW:
+        success = DecodeVoxRaw(data, file);
+        break;
+    }
+    if (!success)
+    {
+        SDL_Log("Failed to decode model: %s", path);
+        delete data;
+        return nullptr;
+    }
+    data->type = type;
+    if ((flags & SDLX_MODELFLAG_CACHE) && has_sources && !WriteCache(data, cache_file, source_hash))
+    {
+        SDL_Log("Failed to write cache: %s", cache_file.string().data());
+    }
+    return data;
+}
+
+Model* StageModel(Staging& staging, const SDLx_ModelData* data)
+{
+    Model* model = new Model();
     if (!model)
     {
-        SDL_SetError("Failed to allocate model: %s", path);
+        SDL_SetError("Failed to allocate model");
         return nullptr;
     }
-    model->min.x = std::numeric_limits<float>::max();
-    model->min.y = std::numeric_limits<float>::max();
-    model->min.z = std::numeric_limits<float>::max();
-    model->max.x = std::numeric_limits<float>::lowest();
-    model->max.y = std::numeric_limits<float>::lowest();
-    model->max.z = std::numeric_limits<float>::lowest();
+    model->type = data->type;
+    model->min = data->min;
+    model->max = data->max;
     bool success = false;
-    switch (type)
+    switch (data->type)
     {
     case SDLX_MODELTYPE_GLTF:
-        success = LoadGltf(model, device, copy_pass, file);
+        success = UploadGltf(model, staging, data);
         break;
     case SDLX_MODELTYPE_VOXOBJ:
-        success = LoadVoxObj(model, device, copy_pass, file);
+        success = UploadVoxObj(model, staging, data);
         break;
     case SDLX_MODELTYPE_VOXRAW:
-        success = LoadVoxRaw(model, device, copy_pass, file);
+        success = UploadVoxRaw(model, staging, data);
         break;
     }
+    if (success && !FlushStaging(staging))
+    {
+        SDL_Log("Failed to flush staging");
+        success = false;
+    }
     if (!success)
     {
-        SDL_Log("Failed to create model: %s", path);
-        delete model;
+        SDL_Log("Failed to create model");
+        ReleaseStaging(staging);
+        SDLx_ModelDestroy(staging.device, model);
+        return nullptr;
+    }
+    return model;
+}
+
+SDLx_Model* SDLx_ModelUpload(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const SDLx_ModelData* data)
+{
+    if (!device)
+    {
+        SDL_InvalidParamError("device");
+        return nullptr;
+    }
+    if (!copy_pass)
+    {
+        SDL_InvalidParamError("copy_pass");
+        return nullptr;
+    }
+    if (!data)
+    {
+        SDL_InvalidParamError("data");
+        return nullptr;
+    }
+    Staging staging{};
+    staging.device = device;
+    Model* model = StageModel(staging, data);
+    if (!model)
+    {
         return nullptr;
     }
-    model->type = type;
+    RecordStaging(model, staging, copy_pass);
     return model;
 }
 
+void SDLx_ModelDestroyData(SDLx_ModelData* data)
+{
+    delete static_cast<Data*>(data);
+}
+
 void SDLx_ModelDestroy(SDL_GPUDevice* device, SDLx_Model* model)
 {
     if (!device)
@@ -96,37 +274,22 @@ void SDLx_ModelDestroy(SDL_GPUDevice* device, SDLx_Model* model)
     {
         return;
     }
-    switch (model->type)
+    Model* owner = static_cast<Model*>(model);
+    for (SDL_GPUBuffer* buffer : owner->buffers)
     {
-    case SDLX_MODELTYPE_GLTF:
-        for (int i = 0; i < model->gltf.num_meshes; i++)
-        {
-            SDLx_ModelMesh& mesh = model->gltf.meshes[i];
-            for (int j = 0; j < mesh.num_primitives; j++)
-            {
-                SDLx_ModelPrimitive& primitive = mesh.primitives[j];
-                SDL_ReleaseGPUBuffer(device, primitive.position_buffer);
-                SDL_ReleaseGPUBuffer(device, primitive.texcoord_buffer);
-                SDL_ReleaseGPUBuffer(device, primitive.normal_buffer);
-                SDL_ReleaseGPUBuffer(device, primitive.index_buffer);
-                SDL_ReleaseGPUTexture(device, primitive.color_texture);
-                SDL_ReleaseGPUTexture(device, primitive.normal_texture);
-            }
-            delete mesh.primitives;
-        }
-        delete model->gltf.meshes;
-        delete model->gltf.nodes;
-        break;
-    case SDLX_MODELTYPE_VOXOBJ:
-        SDL_ReleaseGPUBuffer(device, model->vox_obj.vertex_buffer);
-        SDL_ReleaseGPUBuffer(device, model->vox_obj.index_buffer);
-        SDL_ReleaseGPUTexture(device, model->vox_obj.palette_texture);
-        break;
-    case SDLX_MODELTYPE_VOXRAW:
-        SDL_ReleaseGPUBuffer(device, model->vox_raw.vertex_buffer);
-        SDL_ReleaseGPUBuffer(device, model->vox_raw.index_buffer);
-        SDL_ReleaseGPUBuffer(device, model->vox_raw.instance_buffer);
-        break;
+        SDL_ReleaseGPUBuffer(device, buffer);
+    }
+    for (SDL_GPUTexture* texture : owner->textures)
+    {
+        SDL_ReleaseGPUTexture(device, texture);
+    }
+    for (SDL_GPUBuffer* buffer : owner->shared_buffers)
+    {
+        ReleaseSharedBuffer(device, buffer);
+    }
+    for (SDL_GPUTexture* texture : owner->shared_textures)
+    {
+        ReleaseSharedTexture(device, texture);
     }
-    delete model;
+    delete owner;
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "internal.hpp"
+
+struct SDLx_ModelAsync
+{
+    std::string path;
+    SDLx_ModelType type;
+    SDLx_ModelFlags flags;
+    std::thread thread;
+    std::atomic<bool> staged;
+    Staging staging;
+    Model* model;
+    bool recorded;
+    SDL_GPUFence* fence;
+};
+
+static void Run(SDLx_ModelAsync* async)
+{
+    /* NOTE: resource creation and transfer buffer mapping are thread safe */
+    SDLx_ModelData* data = DecodeModel(async->staging.device, async->path.data(), async->type, async->flags);
+    if (data)
+    {
+        async->model = StageModel(async->staging, data);
+        SDLx_ModelDestroyData(data);
+    }
+    async->staged.store(true, std::memory_order_release);
+}
+
+SDLx_ModelAsync* SDLx_ModelLoadAsync(SDL_GPUDevice* device, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags)
+{
+    if (!device)
+    {
+        SDL_InvalidParamError("device");
+        return nullptr;
+    }
+    if (!path)
+    {
+        SDL_InvalidParamError("path");
+        return nullptr;
+    }
+    SDLx_ModelAsync* async = new SDLx_ModelAsync();
+    if (!async)
+    {
+        SDL_SetError("Failed to allocate async: %s", path);
+        return nullptr;
+    }
+    async->path = path;
+    async->type = type;
+    async->flags = flags;
+    async->staging.device = device;
+    async->thread = std::thread(Run, async);
+    return async;
+}
+
+bool SDLx_ModelUploadAsync(SDLx_ModelAsync* async, SDL_GPUCopyPass* copy_pass)
+{
+    if (!async)
+    {
+        SDL_InvalidParamError("async");
+        return false;
+    }
+    if (!copy_pass)
+    {
+        SDL_InvalidParamError("copy_pass");
+        return false;
+    }
+    if (async->recorded)
+    {
+        return true;
+    }
+    if (!async->staged.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    if (!async->model)
+    {
+        SDL_SetError("Failed to load model: %s", async->path.data());
+        return false;
+    }
+    RecordStaging(async->model, async->staging, copy_pass);
+    async->recorded = true;
+    return true;
+}
+
+void SDLx_ModelFenceAsync(SDLx_ModelAsync* async, SDL_GPUFence* fence)
+{
+    if (!async)
+    {
+        SDL_InvalidParamError("async");
+        return;
+    }
+    if (!async->recorded)
+    {
+        SDL_SetError("Upload not recorded: %s", async->path.data());
+        return;
+    }
+    if (async->fence)
+    {
+        SDL_ReleaseGPUFence(async->staging.device, async->fence);
+    }
+    async->fence = fence;
+}
+
+bool SDLx_ModelIsReady(SDLx_ModelAsync* async)
+{
+    if (!async)
+    {
+        SDL_InvalidParamError("async");
+        return false;
+    }
+    if (!async->staged.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    if (!async->model)
+    {
+        return true;
+    }
+    /* recorded uploads are only done once the fence of their submit signals */
+    if (!async->recorded || !async->fence)
+    {
+        return false;
+    }
+    return SDL_QueryGPUFence(async->staging.device, async->fence);
+}
+
+SDLx_Model* SDLx_ModelWait(SDLx_ModelAsync* async)
+{
+    if (!async)
+    {
+        SDL_InvalidParamError("async");
+        return nullptr;
+    }
+    async->thread.join();
+    SDL_GPUDevice* device = async->staging.device;
+    SDLx_Model* model = async->model;
+    if (model && !async->recorded)
+    {
+        SDL_SetError("Upload not recorded: %s", async->path.data());
+        ReleaseStaging(async->staging);
+        SDLx_ModelDestroy(device, model);
+        model = nullptr;
+    }
+    if (async->fence)
+    {
+        SDL_WaitForGPUFences(device, true, &async->fence, 1);
+        SDL_ReleaseGPUFence(device, async->fence);
+    }
+    delete async;
+    return model;
+}
\ No newline at end of file
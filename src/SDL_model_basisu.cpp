@@ -0,0 +1,630 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "internal.hpp"
+
+/*
+ * BasisLZ/ETC1S transcoding for KTX2. The global data holds Huffman coded
+ * endpoint and selector codebooks shared by every level, and each level is a
+ * slice of Huffman coded codebook indices, with an optional second slice
+ * whose green channel is the alpha. Slices decode to RGBA8 and are then
+ * compressed to BC7, which CreateTexture transcodes again when the device
+ * can't sample it.
+ */
+
+static constexpr int MaxCodeSize = 16;
+static constexpr int EndpointRepeatSymbol = 256;
+static constexpr int EndpointRepeatBits = 4;
+static constexpr int EndpointRepeatMin = 3;
+static constexpr int SelectorRunBits = 7;
+static constexpr int SelectorRunMin = 3;
+static constexpr int SelectorRunSymbols = 64;
+
+static constexpr int Intensities[8][4] =
+{
+    {-8, -2, 2, 8},
+    {-17, -5, 5, 17},
+    {-29, -9, 9, 29},
+    {-42, -13, 13, 42},
+    {-60, -18, 18, 60},
+    {-80, -24, 24, 80},
+    {-106, -33, 33, 106},
+    {-183, -47, 47, 183},
+};
+
+struct BitReader
+{
+    std::span<const uint8_t> data;
+    size_t offset = 0;
+    uint64_t buffer = 0;
+    int buffer_size = 0;
+
+    uint32_t Read(int count)
+    {
+        /* little endian bits, zero past the end */
+        while (buffer_size < count)
+        {
+            uint64_t byte = offset < data.size() ? data[offset] : 0;
+            offset++;
+            buffer |= byte << buffer_size;
+            buffer_size += 8;
+        }
+        uint32_t value = uint32_t(buffer & ((uint64_t(1) << count) - 1));
+        buffer >>= count;
+        buffer_size -= count;
+        return value;
+    }
+
+    uint32_t ReadVlc(int count)
+    {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 32; shift += count)
+        {
+            uint32_t chunk = Read(count + 1);
+            value |= (chunk & ((1u << count) - 1)) << shift;
+            if (!(chunk >> count))
+            {
+                break;
+            }
+        }
+        return value;
+    }
+};
+
+struct Huffman
+{
+    uint16_t counts[MaxCodeSize + 1]{};
+    std::vector<uint16_t> symbols;
+
+    bool Build(std::span<const uint8_t> sizes)
+    {
+        /* canonical codes, shorter first and then by symbol */
+        std::fill(std::begin(counts), std::end(counts), 0);
+        for (uint8_t size : sizes)
+        {
+            counts[size]++;
+        }
+        int left = 1;
+        for (int size = 1; size <= MaxCodeSize; size++)
+        {
+            left = (left << 1) - counts[size];
+            if (left < 0)
+            {
+                return false;
+            }
+        }
+        uint16_t offsets[MaxCodeSize + 2]{};
+        for (int size = 1; size <= MaxCodeSize; size++)
+        {
+            offsets[size + 1] = offsets[size] + counts[size];
+        }
+        symbols.assign(offsets[MaxCodeSize + 1], 0);
+        for (size_t symbol = 0; symbol < sizes.size(); symbol++)
+        {
+            if (sizes[symbol])
+            {
+                symbols[offsets[sizes[symbol]]++] = uint16_t(symbol);
+            }
+        }
+        return true;
+    }
+
+    int Decode(BitReader& reader) const
+    {
+        /* codes are stored most significant bit first */
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int size = 1; size <= MaxCodeSize; size++)
+        {
+            code |= reader.Read(1);
+            int count = counts[size];
+            if (code - count < first)
+            {
+                return symbols[index + code - first];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    bool Read(BitReader& reader)
+    {
+        static constexpr uint8_t Order[21] = {17, 18, 19, 20, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15, 16};
+        uint32_t num_symbols = reader.Read(14);
+        if (!num_symbols)
+        {
+            symbols.clear();
+            std::fill(std::begin(counts), std::end(counts), 0);
+            return true;
+        }
+        uint32_t num_code_sizes = reader.Read(5);
+        if (!num_code_sizes || num_code_sizes > 21)
+        {
+            return false;
+        }
+        uint8_t code_sizes[21]{};
+        for (uint32_t i = 0; i < num_code_sizes; i++)
+        {
+            code_sizes[Order[i]] = reader.Read(3);
+        }
+        Huffman code_size_huffman;
+        if (!code_size_huffman.Build(code_sizes))
+        {
+            return false;
+        }
+        std::vector<uint8_t> sizes(num_symbols);
+        for (uint32_t i = 0; i < num_symbols;)
+        {
+            int symbol = code_size_huffman.Decode(reader);
+            uint32_t count = 1;
+            uint8_t size = 0;
+            if (symbol < 0)
+            {
+                return false;
+            }
+            else if (symbol <= MaxCodeSize)
+            {
+                size = symbol;
+            }
+            else if (symbol == 17)
+            {
+                count = reader.Read(3) + 3;
+            }
+            else if (symbol == 18)
+            {
+                count = reader.Read(7) + 11;
+            }
+            else
+            {
+                count = symbol == 19 ? reader.Read(2) + 3 : reader.Read(7) + 7;
+                size = i ? sizes[i - 1] : 0;
+                if (!size)
+                {
+                    return false;
+                }
+            }
+            if (count > num_symbols - i)
+            {
+                return false;
+            }
+            std::fill_n(sizes.begin() + i, count, size);
+            i += count;
+        }
+        return Build(sizes);
+    }
+};
+
+struct Endpoint
+{
+    uint8_t color[3];
+    uint8_t intensity;
+};
+
+struct Selector
+{
+    uint8_t rows[4];
+};
+
+struct Codebooks
+{
+    std::vector<Endpoint> endpoints;
+    std::vector<Selector> selectors;
+    Huffman endpoint_huffman;
+    Huffman delta_huffman;
+    Huffman selector_huffman;
+    Huffman run_huffman;
+    uint32_t history_size = 0;
+};
+
+static bool ReadEndpoints(std::span<const uint8_t> data, Codebooks& codebooks)
+{
+    BitReader reader{data};
+    Huffman color_huffmans[3];
+    Huffman intensity_huffman;
+    for (Huffman& huffman : color_huffmans)
+    {
+        if (!huffman.Read(reader))
+        {
+            return false;
+        }
+    }
+    if (!intensity_huffman.Read(reader))
+    {
+        return false;
+    }
+    bool grayscale = reader.Read(1);
+    /* each value is a delta from the previous endpoint, coded by how large that was */
+    int prev_colors[3] = {16, 16, 16};
+    int prev_intensity = 0;
+    for (Endpoint& endpoint : codebooks.endpoints)
+    {
+        int intensity = intensity_huffman.Decode(reader);
+        if (intensity < 0)
+        {
+            return false;
+        }
+        prev_intensity = endpoint.intensity = (prev_intensity + intensity) & 7;
+        for (int c = 0; c < (grayscale ? 1 : 3); c++)
+        {
+            int model = prev_colors[c] <= 9 ? 0 : prev_colors[c] <= 21 ? 1 : 2;
+            int delta = color_huffmans[model].Decode(reader);
+            if (delta < 0)
+            {
+                return false;
+            }
+            prev_colors[c] = endpoint.color[c] = (prev_colors[c] + delta) & 31;
+        }
+        if (grayscale)
+        {
+            endpoint.color[1] = endpoint.color[2] = endpoint.color[0];
+        }
+    }
+    return true;
+}
+
+static bool ReadSelectors(std::span<const uint8_t> data, Codebooks& codebooks)
+{
+    BitReader reader{data};
+    /* global and hybrid codebooks were removed from the format */
+    if (reader.Read(1) || reader.Read(1))
+    {
+        return false;
+    }
+    if (reader.Read(1))
+    {
+        for (Selector& selector : codebooks.selectors)
+        {
+            for (uint8_t& row : selector.rows)
+            {
+                row = reader.Read(8);
+            }
+        }
+        return true;
+    }
+    Huffman huffman;
+    if (!huffman.Read(reader))
+    {
+        return false;
+    }
+    Selector prev_selector{};
+    for (size_t i = 0; i < codebooks.selectors.size(); i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            if (!i)
+            {
+                prev_selector.rows[j] = reader.Read(8);
+                continue;
+            }
+            int delta = huffman.Decode(reader);
+            if (delta < 0)
+            {
+                return false;
+            }
+            prev_selector.rows[j] ^= delta;
+        }
+        codebooks.selectors[i] = prev_selector;
+    }
+    return true;
+}
+
+static bool ReadTables(std::span<const uint8_t> data, Codebooks& codebooks)
+{
+    BitReader reader{data};
+    if (!codebooks.endpoint_huffman.Read(reader) || codebooks.endpoint_huffman.symbols.empty() ||
+        !codebooks.delta_huffman.Read(reader) ||
+        !codebooks.selector_huffman.Read(reader) ||
+        !codebooks.run_huffman.Read(reader))
+    {
+        return false;
+    }
+    codebooks.history_size = reader.Read(13);
+    return true;
+}
+
+struct SelectorHistory
+{
+    /* approximately most recently used first */
+    std::vector<uint32_t> values;
+    size_t rover;
+
+    SelectorHistory(uint32_t size)
+        : values(size)
+        , rover(size / 2)
+    {
+    }
+
+    void Add(uint32_t value)
+    {
+        values[rover++] = value;
+        if (rover == values.size())
+        {
+            rover = values.size() / 2;
+        }
+    }
+
+    void Use(uint32_t index)
+    {
+        std::swap(values[index / 2], values[index]);
+    }
+};
+
+static bool DecodeSlice(const Codebooks& codebooks, std::span<const uint8_t> data, uint32_t width, uint32_t height, uint8_t* pixels, bool alpha)
+{
+    BitReader reader{data};
+    uint32_t num_blocks_x = (width + 3) / 4;
+    uint32_t num_blocks_y = (height + 3) / 4;
+    uint32_t num_selectors = uint32_t(codebooks.selectors.size());
+    uint32_t run_symbol = num_selectors + codebooks.history_size;
+    SelectorHistory history(codebooks.history_size);
+    /* predictions come in 2x2 groups, with the lower row's half kept from the upper row */
+    std::vector<uint8_t> lower_predictions(num_blocks_x);
+    std::vector<uint16_t> endpoint_rows[2];
+    endpoint_rows[0].resize(num_blocks_x);
+    endpoint_rows[1].resize(num_blocks_x);
+    uint32_t predictions = 0;
+    int prev_prediction = 0;
+    uint32_t prediction_repeats = 0;
+    uint32_t endpoint_index = 0;
+    uint32_t selector_repeats = 0;
+    for (uint32_t block_y = 0; block_y < num_blocks_y; block_y++)
+    {
+        std::vector<uint16_t>& endpoint_row = endpoint_rows[block_y & 1];
+        const std::vector<uint16_t>& upper_endpoint_row = endpoint_rows[~block_y & 1];
+        for (uint32_t block_x = 0; block_x < num_blocks_x; block_x++)
+        {
+            if (!(block_x & 1) && !(block_y & 1))
+            {
+                if (prediction_repeats)
+                {
+                    prediction_repeats--;
+                    predictions = prev_prediction;
+                }
+                else
+                {
+                    int symbol = codebooks.endpoint_huffman.Decode(reader);
+                    if (symbol < 0)
+                    {
+                        return false;
+                    }
+                    if (symbol == EndpointRepeatSymbol)
+                    {
+                        prediction_repeats = reader.ReadVlc(EndpointRepeatBits) + EndpointRepeatMin - 1;
+                        predictions = prev_prediction;
+                    }
+                    else
+                    {
+                        prev_prediction = predictions = symbol;
+                    }
+                }
+                lower_predictions[block_x] = predictions >> 4;
+            }
+            else if (!(block_x & 1))
+            {
+                predictions = lower_predictions[block_x];
+            }
+            switch (predictions & 3)
+            {
+            case 0:
+                if (!block_x)
+                {
+                    return false;
+                }
+                break;
+            case 1:
+                if (!block_y)
+                {
+                    return false;
+                }
+                endpoint_index = upper_endpoint_row[block_x];
+                break;
+            case 2:
+                if (!block_x || !block_y)
+                {
+                    return false;
+                }
+                endpoint_index = upper_endpoint_row[block_x - 1];
+                break;
+            case 3:
+            {
+                int delta = codebooks.delta_huffman.Decode(reader);
+                if (delta < 0)
+                {
+                    return false;
+                }
+                endpoint_index = (endpoint_index + delta) % codebooks.endpoints.size();
+                break;
+            }
+            }
+            predictions >>= 2;
+            endpoint_row[block_x] = uint16_t(endpoint_index);
+            uint32_t selector_index;
+            uint32_t symbol = num_selectors;
+            if (selector_repeats)
+            {
+                selector_repeats--;
+            }
+            else
+            {
+                int value = codebooks.selector_huffman.Decode(reader);
+                if (value < 0)
+                {
+                    return false;
+                }
+                symbol = value;
+                if (symbol == run_symbol)
+                {
+                    int run = codebooks.run_huffman.Decode(reader);
+                    if (run < 0)
+                    {
+                        return false;
+                    }
+                    selector_repeats = run == SelectorRunSymbols - 1 ? reader.ReadVlc(SelectorRunBits) + SelectorRunMin : run + SelectorRunMin;
+                    if (selector_repeats > num_blocks_x * num_blocks_y)
+                    {
+                        return false;
+                    }
+                    selector_repeats--;
+                    symbol = num_selectors;
+                }
+            }
+            if (symbol >= num_selectors)
+            {
+                uint32_t history_index = symbol - num_selectors;
+                if (history_index >= history.values.size())
+                {
+                    return false;
+                }
+                selector_index = history.values[history_index];
+                if (history_index)
+                {
+                    history.Use(history_index);
+                }
+            }
+            else
+            {
+                selector_index = symbol;
+                if (codebooks.history_size)
+                {
+                    history.Add(selector_index);
+                }
+            }
+            if (selector_index >= num_selectors)
+            {
+                return false;
+            }
+            const Endpoint& endpoint = codebooks.endpoints[endpoint_index];
+            const Selector& selector = codebooks.selectors[selector_index];
+            uint8_t colors[4][3];
+            for (int i = 0; i < 4; i++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    int value = (endpoint.color[c] << 3) | (endpoint.color[c] >> 2);
+                    colors[i][c] = std::clamp(value + Intensities[endpoint.intensity][i], 0, 255);
+                }
+            }
+            for (uint32_t y = 0; y < 4 && block_y * 4 + y < height; y++)
+            {
+                for (uint32_t x = 0; x < 4 && block_x * 4 + x < width; x++)
+                {
+                    const uint8_t* color = colors[(selector.rows[y] >> (x * 2)) & 3];
+                    uint8_t* pixel = pixels + ((block_y * 4 + y) * width + block_x * 4 + x) * 4;
+                    if (alpha)
+                    {
+                        pixel[3] = color[1];
+                    }
+                    else
+                    {
+                        std::memcpy(pixel, color, 3);
+                        pixel[3] = 255;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+static T Read(std::span<const uint8_t> span, size_t offset)
+{
+    T data{};
+    if (offset + sizeof(data) <= span.size())
+    {
+        std::memcpy(&data, span.data() + offset, sizeof(data));
+    }
+    return data;
+}
+
+static std::span<const uint8_t> Subspan(std::span<const uint8_t> span, uint64_t offset, uint64_t size)
+{
+    if (offset > span.size() || size > span.size() - offset)
+    {
+        return {};
+    }
+    return span.subspan(offset, size);
+}
+
+bool DecodeBasisLz(std::span<const uint8_t> global_data, std::span<const std::span<const uint8_t>> levels, uint32_t width, uint32_t height, bool flip, SDLx_ModelImage& image)
+{
+    uint32_t num_levels = uint32_t(levels.size());
+    uint64_t descs_size = uint64_t(num_levels) * 20;
+    uint64_t endpoints_size = Read<uint32_t>(global_data, 4);
+    uint64_t selectors_size = Read<uint32_t>(global_data, 8);
+    uint64_t tables_size = Read<uint32_t>(global_data, 12);
+    uint64_t endpoints_offset = 20 + descs_size;
+    uint64_t selectors_offset = endpoints_offset + endpoints_size;
+    uint64_t tables_offset = selectors_offset + selectors_size;
+    Codebooks codebooks;
+    codebooks.endpoints.resize(Read<uint16_t>(global_data, 0));
+    codebooks.selectors.resize(Read<uint16_t>(global_data, 2));
+    if (tables_offset + tables_size > global_data.size() || codebooks.endpoints.empty() || codebooks.selectors.empty() ||
+        !ReadEndpoints(global_data.subspan(endpoints_offset, endpoints_size), codebooks) ||
+        !ReadSelectors(global_data.subspan(selectors_offset, selectors_size), codebooks) ||
+        !ReadTables(global_data.subspan(tables_offset, tables_size), codebooks))
+    {
+        SDL_Log("Failed to parse basisu codebooks");
+        return false;
+    }
+    size_t size = 0;
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        size += SDL_CalculateGPUTextureFormatSize(SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM, std::max(width >> level, 1u), std::max(height >> level, 1u), 1);
+    }
+    uint8_t* pixels = static_cast<uint8_t*>(SDL_malloc(size));
+    if (!pixels)
+    {
+        SDL_Log("Failed to allocate basisu levels");
+        return false;
+    }
+    uint8_t* dst_data = pixels;
+    std::vector<uint8_t> texels;
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        uint32_t level_width = std::max(width >> level, 1u);
+        uint32_t level_height = std::max(height >> level, 1u);
+        size_t desc = 20 + level * 20;
+        uint32_t flags = Read<uint32_t>(global_data, desc);
+        std::span<const uint8_t> rgb = Subspan(levels[level], Read<uint32_t>(global_data, desc + 4), Read<uint32_t>(global_data, desc + 8));
+        std::span<const uint8_t> alpha = Subspan(levels[level], Read<uint32_t>(global_data, desc + 12), Read<uint32_t>(global_data, desc + 16));
+        texels.resize(size_t(level_width) * level_height * 4);
+        /* P-frames only exist in animations and predict from the previous image */
+        if ((flags & 0x2) || rgb.empty() || (Read<uint32_t>(global_data, desc + 16) && alpha.empty()) ||
+            !DecodeSlice(codebooks, rgb, level_width, level_height, texels.data(), false) ||
+            (!alpha.empty() && !DecodeSlice(codebooks, alpha, level_width, level_height, texels.data(), true)))
+        {
+            SDL_Log("Invalid basisu level: %u", level);
+            SDL_free(pixels);
+            return false;
+        }
+        if (flip)
+        {
+            /* the stb_image path loads bottom-up */
+            size_t row_size = size_t(level_width) * 4;
+            for (uint32_t y = 0; y < level_height / 2; y++)
+            {
+                std::swap_ranges(texels.begin() + y * row_size, texels.begin() + (y + 1) * row_size,
+                    texels.begin() + (level_height - 1 - y) * row_size);
+            }
+        }
+        Compress(SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM, texels.data(), level_width, level_height, dst_data);
+        dst_data += SDL_CalculateGPUTextureFormatSize(SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM, level_width, level_height, 1);
+    }
+    image.pixels = pixels;
+    image.width = width;
+    image.height = height;
+    image.num_levels = num_levels;
+    image.format = SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+    return true;
+}
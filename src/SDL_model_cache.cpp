@@ -0,0 +1,634 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "internal.hpp"
+
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+#error "Big endian currently unsupported"
+#endif
+
+/*
+ * .sdlxm layout, little-endian with every array at a 16 byte aligned offset:
+ *
+ * CacheHeader
+ * CacheMesh[num_meshes] / CachePrimitive[num_primitives] / SDLx_ModelNodeData[num_nodes]
+ * and, with SDLX_MODELFLAG_MESHLETS, the meshlets, vertices and triangles of each primitive
+ * or for vox raw SDLx_ModelVoxRawShape[num_meshes] / SDLx_ModelVoxRawNodeData[num_nodes]
+ * and, with SDLX_MODELFLAG_OCTREE, CacheOctree[num_meshes] and their nodes and bricks
+ * CacheImage[num_images], keys and texels
+ * vertex, index and instance streams, exactly as staged
+ *
+ * Offsets are relative to the start of the file and 0 means absent.
+ */
+
+static constexpr char CacheMagic[4] = {'S', 'D', 'L', 'X'};
+static constexpr uint32_t CacheVersion = 8;
+static constexpr uint64_t CacheAlignment = 16;
+
+struct CacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint32_t type;
+    uint32_t flags;
+    SDLx_ModelVec3 min;
+    SDLx_ModelVec3 max;
+    uint32_t num_meshes;
+    uint32_t num_primitives;
+    uint32_t num_nodes;
+    uint32_t num_images;
+    uint64_t meshes;
+    uint64_t primitives;
+    uint64_t nodes;
+    uint64_t images;
+    uint64_t vertices;
+    uint64_t indices;
+    uint32_t num_vertices;
+    uint32_t num_indices;
+    uint32_t index_element_size;
+    uint32_t padding;
+    uint64_t octrees;
+    SDLx_ModelIndexStats source_index_stats;
+    SDLx_ModelIndexStats index_stats;
+};
+
+struct CacheMesh
+{
+    uint32_t num_primitives;
+};
+
+struct CachePrimitive
+{
+    uint64_t positions;
+    uint64_t texcoords;
+    uint64_t normals;
+    uint64_t indices;
+    uint32_t num_vertices;
+    uint32_t num_indices;
+    uint32_t index_element_size;
+    int32_t color_image;
+    int32_t normal_image;
+    int32_t num_lods;
+    SDLx_ModelLod lods[SDLX_MODEL_MAX_LODS];
+    uint64_t meshlets;
+    uint64_t meshlet_vertices;
+    uint64_t meshlet_triangles;
+    uint32_t num_meshlets;
+    uint32_t num_meshlet_vertices;
+    uint32_t num_meshlet_triangles;
+    uint32_t padding;
+};
+
+struct CacheImage
+{
+    uint64_t pixels;
+    uint64_t size;
+    uint64_t key;
+    uint32_t key_size;
+    int32_t width;
+    int32_t height;
+    int32_t num_levels;
+    uint32_t format;
+    uint32_t padding;
+};
+
+struct CacheOctree
+{
+    uint64_t nodes;
+    uint64_t bricks;
+    uint32_t num_nodes;
+    uint32_t num_bricks;
+    int32_t depth;
+    int32_t size;
+};
+
+static_assert(sizeof(CacheHeader) == 152);
+static_assert(sizeof(CachePrimitive) == 144);
+static_assert(sizeof(CacheImage) == 48);
+static_assert(sizeof(CacheOctree) == 32);
+static_assert(sizeof(SDLx_ModelMeshlet) == 64);
+static_assert(sizeof(SDLx_ModelVoxOctreeNode) == 8);
+static_assert(sizeof(SDLx_ModelVoxOctreeBrick) == 72);
+static_assert(sizeof(SDLx_ModelNodeData) == 68);
+static_assert(sizeof(SDLx_ModelVoxRawShape) == 8);
+static_assert(sizeof(SDLx_ModelVoxRawNodeData) == 68);
+
+/* loader options that change the decoded data */
+static SDLx_ModelFlags GetCacheFlags(SDLx_ModelFlags flags)
+{
+    return flags & ~(SDLX_MODELFLAG_CACHE | SDLX_MODELFLAG_INTERLEAVE | SDLX_MODELFLAG_PACK |
+        SDLX_MODELFLAG_QUANTIZE | SDLX_MODELFLAG_UNORM_TEXCOORDS);
+}
+
+static size_t GetImageSize(const SDLx_ModelImage& image)
+{
+    size_t size = 0;
+    for (int level = 0; level < image.num_levels; level++)
+    {
+        uint32_t width = std::max(image.width >> level, 1);
+        uint32_t height = std::max(image.height >> level, 1);
+        size += SDL_CalculateGPUTextureFormatSize(image.format, width, height, 1);
+    }
+    return size;
+}
+
+struct Writer
+{
+    std::vector<uint8_t> bytes;
+
+    uint64_t Write(const void* data, size_t size)
+    {
+        if (!data || !size)
+        {
+            return 0;
+        }
+        uint64_t offset = (bytes.size() + CacheAlignment - 1) / CacheAlignment * CacheAlignment;
+        bytes.resize(offset + size);
+        std::memcpy(bytes.data() + offset, data, size);
+        return offset;
+    }
+};
+
+static void WriteImage(Writer& writer, std::vector<CacheImage>& cache_images, const SDLx_ModelImage& image, const std::string& key)
+{
+    CacheImage& cache_image = cache_images.emplace_back();
+    cache_image.size = GetImageSize(image);
+    cache_image.pixels = writer.Write(image.pixels, cache_image.size);
+    cache_image.key = writer.Write(key.data(), key.size());
+    cache_image.key_size = key.size();
+    cache_image.width = image.width;
+    cache_image.height = image.height;
+    cache_image.num_levels = image.num_levels;
+    cache_image.format = image.format;
+}
+
+bool WriteCache(const Data* data, const std::filesystem::path& path, uint64_t source_hash)
+{
+    Writer writer;
+    CacheHeader header{};
+    writer.bytes.resize(sizeof(header));
+    std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.version = CacheVersion;
+    header.source_hash = source_hash;
+    header.type = data->type;
+    header.flags = GetCacheFlags(data->flags);
+    header.min = data->min;
+    header.max = data->max;
+    header.source_index_stats = data->source_index_stats;
+    header.index_stats = data->index_stats;
+    std::vector<CacheImage> cache_images;
+    switch (data->type)
+    {
+    case SDLX_MODELTYPE_GLTF:
+    {
+        const SDLx_ModelGltfData& gltf = data->gltf;
+        std::vector<CacheMesh> cache_meshes(gltf.num_meshes);
+        std::vector<CachePrimitive> cache_primitives;
+        for (int i = 0; i < gltf.num_meshes; i++)
+        {
+            cache_meshes[i].num_primitives = gltf.meshes[i].num_primitives;
+            for (int j = 0; j < gltf.meshes[i].num_primitives; j++)
+            {
+                const SDLx_ModelPrimitiveData& primitive = gltf.meshes[i].primitives[j];
+                uint32_t index_size = primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+                CachePrimitive& cache_primitive = cache_primitives.emplace_back();
+                cache_primitive.positions = writer.Write(primitive.positions, primitive.num_vertices * sizeof(SDLx_ModelVec3));
+                cache_primitive.texcoords = writer.Write(primitive.texcoords, primitive.num_vertices * sizeof(SDLx_ModelVec2));
+                cache_primitive.normals = writer.Write(primitive.normals, primitive.num_vertices * sizeof(SDLx_ModelVec3));
+                cache_primitive.indices = writer.Write(primitive.indices, primitive.num_indices * index_size);
+                cache_primitive.num_vertices = primitive.num_vertices;
+                cache_primitive.num_indices = primitive.num_indices;
+                cache_primitive.index_element_size = primitive.index_element_size;
+                cache_primitive.color_image = primitive.color_image;
+                cache_primitive.normal_image = primitive.normal_image;
+                cache_primitive.num_lods = primitive.num_lods;
+                std::copy_n(primitive.lods, primitive.num_lods, cache_primitive.lods);
+                cache_primitive.meshlets = writer.Write(primitive.meshlets, primitive.num_meshlets * sizeof(SDLx_ModelMeshlet));
+                cache_primitive.meshlet_vertices = writer.Write(primitive.meshlet_vertices, primitive.num_meshlet_vertices * sizeof(Uint32));
+                cache_primitive.meshlet_triangles = writer.Write(primitive.meshlet_triangles, primitive.num_meshlet_triangles * sizeof(Uint32));
+                cache_primitive.num_meshlets = primitive.num_meshlets;
+                cache_primitive.num_meshlet_vertices = primitive.num_meshlet_vertices;
+                cache_primitive.num_meshlet_triangles = primitive.num_meshlet_triangles;
+            }
+        }
+        for (int i = 0; i < gltf.num_images; i++)
+        {
+            if (!gltf.images[i].pixels)
+            {
+                SDL_Log("Failed to write image: %s", data->image_keys[i].data());
+                return false;
+            }
+            WriteImage(writer, cache_images, gltf.images[i], data->image_keys[i]);
+        }
+        header.num_meshes = cache_meshes.size();
+        header.num_primitives = cache_primitives.size();
+        header.num_nodes = gltf.num_nodes;
+        header.meshes = writer.Write(cache_meshes.data(), cache_meshes.size() * sizeof(CacheMesh));
+        header.primitives = writer.Write(cache_primitives.data(), cache_primitives.size() * sizeof(CachePrimitive));
+        header.nodes = writer.Write(gltf.nodes, gltf.num_nodes * sizeof(SDLx_ModelNodeData));
+        break;
+    }
+    case SDLX_MODELTYPE_VOXOBJ:
+    {
+        uint32_t index_size = data->vox_obj.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+        WriteImage(writer, cache_images, data->vox_obj.palette, std::string());
+        header.vertices = writer.Write(data->vox_obj.vertices, data->vox_obj.num_vertices * sizeof(SDLx_ModelVoxObjVertex));
+        header.indices = writer.Write(data->vox_obj.indices, data->vox_obj.num_indices * index_size);
+        header.num_vertices = data->vox_obj.num_vertices;
+        header.num_indices = data->vox_obj.num_indices;
+        header.index_element_size = data->vox_obj.index_element_size;
+        break;
+    }
+    case SDLX_MODELTYPE_VOXRAW:
+        header.vertices = writer.Write(data->vox_raw.instances, data->vox_raw.num_instances * sizeof(SDLx_ModelVoxRawInstance));
+        header.num_vertices = data->vox_raw.num_instances;
+        header.meshes = writer.Write(data->vox_raw.shapes, data->vox_raw.num_shapes * sizeof(SDLx_ModelVoxRawShape));
+        header.num_meshes = data->vox_raw.num_shapes;
+        header.nodes = writer.Write(data->vox_raw.nodes, data->vox_raw.num_nodes * sizeof(SDLx_ModelVoxRawNodeData));
+        header.num_nodes = data->vox_raw.num_nodes;
+        if (data->vox_raw.octrees)
+        {
+            std::vector<CacheOctree> cache_octrees(data->vox_raw.num_shapes);
+            for (int i = 0; i < data->vox_raw.num_shapes; i++)
+            {
+                const SDLx_ModelVoxOctree& octree = data->vox_raw.octrees[i];
+                cache_octrees[i].nodes = writer.Write(octree.nodes, octree.num_nodes * sizeof(SDLx_ModelVoxOctreeNode));
+                cache_octrees[i].bricks = writer.Write(octree.bricks, octree.num_bricks * sizeof(SDLx_ModelVoxOctreeBrick));
+                cache_octrees[i].num_nodes = octree.num_nodes;
+                cache_octrees[i].num_bricks = octree.num_bricks;
+                cache_octrees[i].depth = octree.depth;
+                cache_octrees[i].size = octree.size;
+            }
+            header.octrees = writer.Write(cache_octrees.data(), cache_octrees.size() * sizeof(CacheOctree));
+        }
+        break;
+    }
+    header.num_images = cache_images.size();
+    header.images = writer.Write(cache_images.data(), cache_images.size() * sizeof(CacheImage));
+    std::memcpy(writer.bytes.data(), &header, sizeof(header));
+    /* written aside and renamed so concurrent readers never map a partial file */
+    std::filesystem::path temporary_path = path;
+    temporary_path += "." + std::to_string(SDL_GetCurrentThreadID()) + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(writer.bytes.data()), writer.bytes.size()))
+        {
+            SDL_Log("Failed to write cache: %s", temporary_path.string().data());
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+        SDL_Log("Failed to rename cache: %s, %s", path.string().data(), error.message().data());
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+static T* GetArray(std::span<const uint8_t> file, uint64_t offset, uint64_t count)
+{
+    if (!offset || offset % alignof(T) || offset > file.size() || count > (file.size() - offset) / sizeof(T))
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<T*>(const_cast<uint8_t*>(file.data() + offset));
+}
+
+/* a stale or truncated cache must not turn into out of range indexed draws */
+static bool ValidateIndices(const void* indices, uint32_t num_indices, SDL_GPUIndexElementSize index_element_size, uint32_t num_vertices)
+{
+    for (uint32_t i = 0; i < num_indices; i++)
+    {
+        uint32_t index;
+        if (index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            index = static_cast<const uint16_t*>(indices)[i];
+        }
+        else
+        {
+            index = static_cast<const uint32_t*>(indices)[i];
+        }
+        if (index >= num_vertices)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* each level's children must follow in the next level as BuildVoxOctree lays them out, ending in the bricks */
+static bool ValidateOctree(const SDLx_ModelVoxOctree& octree)
+{
+    uint64_t level_offset = 0;
+    uint64_t level_size = 1;
+    for (int level = 0; level < octree.depth; level++)
+    {
+        bool last = level + 1 == octree.depth;
+        uint64_t child = last ? 0 : level_offset + level_size;
+        uint64_t num_children = last ? octree.num_bricks : octree.num_nodes;
+        if (level_offset + level_size > octree.num_nodes)
+        {
+            return false;
+        }
+        for (uint64_t i = level_offset; i < level_offset + level_size; i++)
+        {
+            const SDLx_ModelVoxOctreeNode& node = octree.nodes[i];
+            if (node.first_child != child)
+            {
+                return false;
+            }
+            child += std::popcount(node.child_mask);
+        }
+        if (child > num_children)
+        {
+            return false;
+        }
+        level_offset += level_size;
+        level_size = last ? 0 : child - level_offset;
+    }
+    return level_offset == octree.num_nodes;
+}
+
+static bool ReadImage(std::span<const uint8_t> file, const CacheImage& cache_image, SDLx_ModelImage& image, std::string& key)
+{
+    image.width = cache_image.width;
+    image.height = cache_image.height;
+    image.num_levels = cache_image.num_levels;
+    image.format = SDL_GPUTextureFormat(cache_image.format);
+    image.pixels = GetArray<uint8_t>(file, cache_image.pixels, cache_image.size);
+    if (!image.pixels || GetImageSize(image) != cache_image.size)
+    {
+        return false;
+    }
+    if (cache_image.key_size)
+    {
+        const char* key_data = GetArray<const char>(file, cache_image.key, cache_image.key_size);
+        if (!key_data)
+        {
+            return false;
+        }
+        key.assign(key_data, cache_image.key_size);
+    }
+    return true;
+}
+
+bool ReadCache(Data* data, const std::filesystem::path& path, SDLx_ModelType type, const uint64_t* source_hash)
+{
+    std::span<const uint8_t> file = MapFile(data, path);
+    CacheHeader header;
+    if (file.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) || header.version != CacheVersion ||
+        header.flags != GetCacheFlags(data->flags) || (type != SDLX_MODELTYPE_INVALID && header.type != type) ||
+        (source_hash && header.source_hash != *source_hash))
+    {
+        return false;
+    }
+    const CacheImage* cache_images = GetArray<const CacheImage>(file, header.images, header.num_images);
+    if (header.num_images && !cache_images)
+    {
+        SDL_Log("Invalid cache images: %s", path.string().data());
+        return false;
+    }
+    data->type = SDLx_ModelType(header.type);
+    data->min = header.min;
+    data->max = header.max;
+    data->source_index_stats = header.source_index_stats;
+    data->index_stats = header.index_stats;
+    switch (data->type)
+    {
+    case SDLX_MODELTYPE_GLTF:
+    {
+        const CacheMesh* cache_meshes = GetArray<const CacheMesh>(file, header.meshes, header.num_meshes);
+        const CachePrimitive* cache_primitives = GetArray<const CachePrimitive>(file, header.primitives, header.num_primitives);
+        const SDLx_ModelNodeData* nodes = GetArray<const SDLx_ModelNodeData>(file, header.nodes, header.num_nodes);
+        if ((header.num_meshes && !cache_meshes) || (header.num_primitives && !cache_primitives) || (header.num_nodes && !nodes))
+        {
+            SDL_Log("Invalid cache meshes: %s", path.string().data());
+            return false;
+        }
+        data->meshes.resize(header.num_meshes);
+        data->primitives.resize(header.num_primitives);
+        size_t num_primitives = 0;
+        for (uint32_t i = 0; i < header.num_meshes; i++)
+        {
+            SDLx_ModelMeshData& mesh = data->meshes[i];
+            mesh.num_primitives = cache_meshes[i].num_primitives;
+            mesh.primitives = data->primitives.data() + num_primitives;
+            num_primitives += mesh.num_primitives;
+            if (num_primitives > header.num_primitives)
+            {
+                SDL_Log("Invalid cache primitives: %s", path.string().data());
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header.num_primitives; i++)
+        {
+            const CachePrimitive& cache_primitive = cache_primitives[i];
+            SDLx_ModelPrimitiveData& primitive = data->primitives[i];
+            primitive.num_vertices = cache_primitive.num_vertices;
+            primitive.num_indices = cache_primitive.num_indices;
+            primitive.index_element_size = SDL_GPUIndexElementSize(cache_primitive.index_element_size);
+            primitive.color_image = cache_primitive.color_image;
+            primitive.normal_image = cache_primitive.normal_image;
+            if (cache_primitive.num_lods < 0 || cache_primitive.num_lods > SDLX_MODEL_MAX_LODS ||
+                (primitive.index_element_size != SDL_GPU_INDEXELEMENTSIZE_16BIT && primitive.index_element_size != SDL_GPU_INDEXELEMENTSIZE_32BIT))
+            {
+                SDL_Log("Invalid cache primitive: %s", path.string().data());
+                return false;
+            }
+            primitive.num_lods = cache_primitive.num_lods;
+            std::copy_n(cache_primitive.lods, primitive.num_lods, primitive.lods);
+            for (int j = 0; j < primitive.num_lods; j++)
+            {
+                const SDLx_ModelLod& lod = primitive.lods[j];
+                if (lod.first_index > primitive.num_indices || lod.num_indices > primitive.num_indices - lod.first_index)
+                {
+                    SDL_Log("Invalid cache lod: %s", path.string().data());
+                    return false;
+                }
+            }
+            primitive.positions = GetArray<SDLx_ModelVec3>(file, cache_primitive.positions, primitive.num_vertices);
+            primitive.texcoords = GetArray<SDLx_ModelVec2>(file, cache_primitive.texcoords, primitive.num_vertices);
+            primitive.normals = GetArray<SDLx_ModelVec3>(file, cache_primitive.normals, primitive.num_vertices);
+            uint32_t index_size = primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+            primitive.indices = GetArray<uint8_t>(file, cache_primitive.indices, uint64_t(primitive.num_indices) * index_size);
+            if ((cache_primitive.positions && !primitive.positions) || (cache_primitive.texcoords && !primitive.texcoords) ||
+                (cache_primitive.normals && !primitive.normals) || (cache_primitive.indices && !primitive.indices) ||
+                (primitive.indices && !ValidateIndices(primitive.indices, primitive.num_indices, primitive.index_element_size, primitive.num_vertices)))
+            {
+                SDL_Log("Invalid cache primitive: %s", path.string().data());
+                return false;
+            }
+            if (!cache_primitive.num_meshlets)
+            {
+                continue;
+            }
+            primitive.meshlets = GetArray<SDLx_ModelMeshlet>(file, cache_primitive.meshlets, cache_primitive.num_meshlets);
+            primitive.meshlet_vertices = GetArray<Uint32>(file, cache_primitive.meshlet_vertices, cache_primitive.num_meshlet_vertices);
+            primitive.meshlet_triangles = GetArray<Uint32>(file, cache_primitive.meshlet_triangles, cache_primitive.num_meshlet_triangles);
+            primitive.num_meshlets = cache_primitive.num_meshlets;
+            primitive.num_meshlet_vertices = cache_primitive.num_meshlet_vertices;
+            primitive.num_meshlet_triangles = cache_primitive.num_meshlet_triangles;
+            if (!primitive.meshlets || !primitive.meshlet_vertices || !primitive.meshlet_triangles)
+            {
+                SDL_Log("Invalid cache meshlets: %s", path.string().data());
+                return false;
+            }
+            for (uint32_t j = 0; j < primitive.num_meshlets; j++)
+            {
+                const SDLx_ModelMeshlet& meshlet = primitive.meshlets[j];
+                if (meshlet.first_vertex > primitive.num_meshlet_vertices || meshlet.num_vertices > primitive.num_meshlet_vertices - meshlet.first_vertex ||
+                    meshlet.first_triangle > primitive.num_meshlet_triangles || meshlet.num_triangles > primitive.num_meshlet_triangles - meshlet.first_triangle)
+                {
+                    SDL_Log("Invalid cache meshlet: %s", path.string().data());
+                    return false;
+                }
+                for (uint32_t k = 0; k < meshlet.num_triangles; k++)
+                {
+                    uint32_t packed = primitive.meshlet_triangles[meshlet.first_triangle + k];
+                    if ((packed & 0xFF) >= meshlet.num_vertices || ((packed >> 8) & 0xFF) >= meshlet.num_vertices ||
+                        ((packed >> 16) & 0xFF) >= meshlet.num_vertices)
+                    {
+                        SDL_Log("Invalid cache meshlet: %s", path.string().data());
+                        return false;
+                    }
+                }
+            }
+            for (uint32_t j = 0; j < primitive.num_meshlet_vertices; j++)
+            {
+                if (primitive.meshlet_vertices[j] >= primitive.num_vertices)
+                {
+                    SDL_Log("Invalid cache meshlet: %s", path.string().data());
+                    return false;
+                }
+            }
+        }
+        data->nodes.assign(nodes, nodes + header.num_nodes);
+        data->images.resize(header.num_images);
+        data->image_keys.resize(header.num_images);
+        data->image_textures.resize(header.num_images);
+        for (uint32_t i = 0; i < header.num_images; i++)
+        {
+            if (!ReadImage(file, cache_images[i], data->images[i], data->image_keys[i]))
+            {
+                SDL_Log("Invalid cache image: %s", path.string().data());
+                return false;
+            }
+            data->images[i].key = data->image_keys[i].data();
+        }
+        data->gltf.meshes = data->meshes.data();
+        data->gltf.num_meshes = data->meshes.size();
+        data->gltf.nodes = data->nodes.data();
+        data->gltf.num_nodes = data->nodes.size();
+        data->gltf.images = data->images.data();
+        data->gltf.num_images = data->images.size();
+        break;
+    }
+    case SDLX_MODELTYPE_VOXOBJ:
+    {
+        std::string key;
+        data->vox_obj.vertices = GetArray<SDLx_ModelVoxObjVertex>(file, header.vertices, header.num_vertices);
+        data->vox_obj.index_element_size = SDL_GPUIndexElementSize(header.index_element_size);
+        uint32_t index_size = data->vox_obj.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+        data->vox_obj.indices = GetArray<uint8_t>(file, header.indices, uint64_t(header.num_indices) * index_size);
+        data->vox_obj.num_vertices = header.num_vertices;
+        data->vox_obj.num_indices = header.num_indices;
+        if (!data->vox_obj.vertices || !data->vox_obj.indices || header.num_images != 1 ||
+            !ValidateIndices(data->vox_obj.indices, data->vox_obj.num_indices, data->vox_obj.index_element_size, data->vox_obj.num_vertices) ||
+            !ReadImage(file, cache_images[0], data->vox_obj.palette, key))
+        {
+            SDL_Log("Invalid cache vox obj: %s", path.string().data());
+            return false;
+        }
+        break;
+    }
+    case SDLX_MODELTYPE_VOXRAW:
+    {
+        const SDLx_ModelVoxRawShape* shapes = GetArray<const SDLx_ModelVoxRawShape>(file, header.meshes, header.num_meshes);
+        const SDLx_ModelVoxRawNodeData* nodes = GetArray<const SDLx_ModelVoxRawNodeData>(file, header.nodes, header.num_nodes);
+        data->vox_raw.instances = GetArray<SDLx_ModelVoxRawInstance>(file, header.vertices, header.num_vertices);
+        data->vox_raw.num_instances = header.num_vertices;
+        if ((header.num_vertices && !data->vox_raw.instances) || (header.num_meshes && !shapes) || (header.num_nodes && !nodes))
+        {
+            SDL_Log("Invalid cache vox raw: %s", path.string().data());
+            return false;
+        }
+        data->vox_shapes.assign(shapes, shapes + header.num_meshes);
+        data->vox_nodes.assign(nodes, nodes + header.num_nodes);
+        for (const SDLx_ModelVoxRawShape& shape : data->vox_shapes)
+        {
+            if (shape.first_instance > header.num_vertices || shape.num_instances > header.num_vertices - shape.first_instance)
+            {
+                SDL_Log("Invalid cache vox shape: %s", path.string().data());
+                return false;
+            }
+        }
+        for (const SDLx_ModelVoxRawNodeData& node : data->vox_nodes)
+        {
+            if (node.shape < 0 || node.shape >= int(header.num_meshes))
+            {
+                SDL_Log("Invalid cache vox node: %s", path.string().data());
+                return false;
+            }
+        }
+        data->vox_raw.shapes = data->vox_shapes.data();
+        data->vox_raw.num_shapes = data->vox_shapes.size();
+        data->vox_raw.nodes = data->vox_nodes.data();
+        data->vox_raw.num_nodes = data->vox_nodes.size();
+        if (data->flags & SDLX_MODELFLAG_OCTREE)
+        {
+            const CacheOctree* cache_octrees = GetArray<const CacheOctree>(file, header.octrees, header.num_meshes);
+            if (header.num_meshes && !cache_octrees)
+            {
+                SDL_Log("Invalid cache vox octrees: %s", path.string().data());
+                return false;
+            }
+            data->vox_octrees.resize(header.num_meshes);
+            for (uint32_t i = 0; i < header.num_meshes; i++)
+            {
+                const CacheOctree& cache_octree = cache_octrees[i];
+                SDLx_ModelVoxOctree& octree = data->vox_octrees[i];
+                octree.nodes = GetArray<SDLx_ModelVoxOctreeNode>(file, cache_octree.nodes, cache_octree.num_nodes);
+                octree.bricks = GetArray<SDLx_ModelVoxOctreeBrick>(file, cache_octree.bricks, cache_octree.num_bricks);
+                octree.num_nodes = cache_octree.num_nodes;
+                octree.num_bricks = cache_octree.num_bricks;
+                octree.depth = cache_octree.depth;
+                octree.size = cache_octree.size;
+                if (!octree.nodes || (octree.num_bricks && !octree.bricks) || octree.depth < 1 || octree.depth > 20 || octree.size != 4 << octree.depth ||
+                    !ValidateOctree(octree))
+                {
+                    SDL_Log("Invalid cache vox octree: %s", path.string().data());
+                    return false;
+                }
+            }
+            data->vox_raw.octrees = data->vox_octrees.data();
+        }
+        break;
+    }
+    default:
+        SDL_Log("Invalid cache type: %s", path.string().data());
+        return false;
+    }
+    return true;
+}
@@ -1,177 +1,527 @@
 #include <SDL3/SDL.h>
 #include <SDLx_model/SDL_model.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
-#include <type_traits>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 #include "cgltf.h"
 #include "internal.hpp"
 
+struct ImagePaths
+{
+    std::filesystem::path path;
+    std::filesystem::path fallback_path;
+};
+
 template<typename T>
-SDL_GPUBuffer* CreateVertexBuffer(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const cgltf_accessor* accessor)
+static T* ReadAttribute(Data* data, const cgltf_accessor* accessor)
 {
-    SDL_GPUTransferBuffer* transfer_buffer;
-    SDL_GPUBuffer* buffer;
+    const cgltf_buffer_view* view = accessor->buffer_view;
+    const uint8_t* src_data = nullptr;
+    if (view && view->buffer->data && !accessor->is_sparse && !accessor->normalized &&
+        accessor->component_type == cgltf_component_type_r_32f &&
+        cgltf_num_components(accessor->type) * sizeof(float) == sizeof(T) && accessor->stride == sizeof(T) &&
+        accessor->offset + accessor->count * sizeof(T) <= view->size)
     {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = accessor->count * sizeof(T);
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
-        {
-            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
-            return nullptr;
-        }
+        src_data = static_cast<const uint8_t*>(view->buffer->data) + view->offset + accessor->offset;
     }
+    if (src_data && reinterpret_cast<uintptr_t>(src_data) % alignof(T) == 0 &&
+        view->buffer->data_free_method != cgltf_data_free_method_memory_free)
     {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-        info.size = accessor->count * sizeof(T);
-        buffer = SDL_CreateGPUBuffer(device, &info);
-        if (!buffer)
-        {
-            SDL_Log("Failed to create buffer: %s", SDL_GetError());
-            return nullptr;
-        }
+        /* packed floats inside a mapped file, used in place */
+        return reinterpret_cast<T*>(const_cast<uint8_t*>(src_data));
     }
-    float* data = static_cast<float*>(SDL_MapGPUTransferBuffer(device, transfer_buffer, false));
-    if (!data)
+    T* values = data->Allocate<T>(accessor->count);
+    if (!values)
     {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        SDL_Log("Failed to allocate attribute");
         return nullptr;
     }
+    if (src_data)
+    {
+        std::memcpy(values, src_data, accessor->count * sizeof(T));
+        return values;
+    }
+    float* dst_data = reinterpret_cast<float*>(values);
     for (uint32_t i = 0; i < accessor->count; i++)
     {
-        if constexpr (std::is_same_v<T, SDLx_ModelVec2>)
-        {
-            cgltf_accessor_read_float(accessor, i, data + i * 2, 2);
-        }
-        else
-        {
-            cgltf_accessor_read_float(accessor, i, data + i * 3, 3);
-        }
+        cgltf_accessor_read_float(accessor, i, dst_data + i * (sizeof(T) / sizeof(float)), sizeof(T) / sizeof(float));
     }
-    SDL_GPUTransferBufferLocation location{};
-    SDL_GPUBufferRegion region{};
-    location.transfer_buffer = transfer_buffer;
-    region.buffer = buffer;
-    region.size = accessor->count * sizeof(T);
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
-    return buffer;
+    return values;
 }
 
-bool CreateIndexBuffer(SDLx_ModelPrimitive& primitive, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const cgltf_accessor* accessor)
+static bool ReadIndices(SDLx_ModelPrimitiveData& primitive, Data* data, const cgltf_accessor* accessor)
 {
-    int stride;
     primitive.num_indices = accessor->count;
     if (accessor->component_type == cgltf_component_type_r_16 || accessor->component_type == cgltf_component_type_r_16u)
     {
         primitive.index_element_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
-        stride = 2;
+        uint16_t* u16_data = data->Allocate<uint16_t>(accessor->count);
+        if (!u16_data)
+        {
+            SDL_Log("Failed to allocate indices");
+            return false;
+        }
+        for (uint32_t i = 0; i < accessor->count; i++)
+        {
+            u16_data[i] = cgltf_accessor_read_index(accessor, i);
+        }
+        primitive.indices = u16_data;
     }
     else
     {
         primitive.index_element_size = SDL_GPU_INDEXELEMENTSIZE_32BIT;
-        stride = 4;
+        uint32_t* u32_data = data->Allocate<uint32_t>(accessor->count);
+        if (!u32_data)
+        {
+            SDL_Log("Failed to allocate indices");
+            return false;
+        }
+        for (uint32_t i = 0; i < accessor->count; i++)
+        {
+            u32_data[i] = cgltf_accessor_read_index(accessor, i);
+        }
+        primitive.indices = u32_data;
     }
-    SDL_GPUTransferBuffer* transfer_buffer;
+    return true;
+}
+
+static void ReadImage(int& index, std::vector<int>& image_indices, std::vector<ImagePaths>& image_paths,
+    const cgltf_data* src_data, const cgltf_texture_view& view, std::filesystem::path& path)
+{
+    index = -1;
+    const cgltf_texture* texture = view.texture;
+    if (!texture)
+    {
+        return;
+    }
+    /* KHR_texture_basisu images come first, the core image stays as a fallback */
+    const cgltf_image* image = texture->image;
+    const cgltf_image* fallback = nullptr;
+    if (texture->has_basisu && texture->basisu_image && texture->basisu_image->uri)
+    {
+        fallback = image && image->uri ? image : nullptr;
+        image = texture->basisu_image;
+    }
+    if (!image || !image->uri)
+    {
+        return;
+    }
+    int& image_index = image_indices[image - src_data->images];
+    if (image_index == -1)
     {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = accessor->count * stride;
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
+        image_index = image_paths.size();
+        ImagePaths& paths = image_paths.emplace_back();
+        paths.path = path.replace_filename(image->uri);
+        if (fallback)
         {
-            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
-            return false;
+            paths.fallback_path = path.replace_filename(fallback->uri);
         }
     }
+    index = image_index;
+}
+
+static bool DecodeImageFile(Data* data, std::span<const uint8_t> file, SDLx_ModelImage& image, void(*&deleter)(void*))
+{
+    static const uint8_t Ktx2Identifier[] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB};
+    if (file.size() >= sizeof(Ktx2Identifier) && !std::memcmp(file.data(), Ktx2Identifier, sizeof(Ktx2Identifier)))
     {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-        info.size = accessor->count * stride;
-        primitive.index_buffer = SDL_CreateGPUBuffer(device, &info);
-        if (!primitive.index_buffer)
+        deleter = SDL_free;
+        return DecodeKtx2(file, image);
+    }
+    if (!DecodeImage(file, image))
+    {
+        return false;
+    }
+    deleter = FreeImage;
+    if (!(data->flags & SDLX_MODELFLAG_MIPMAPS))
+    {
+        return true;
+    }
+    if (!GenerateMipmaps(image))
+    {
+        FreeImage(image.pixels);
+        image.pixels = nullptr;
+        return false;
+    }
+    if (image.num_levels > 1)
+    {
+        deleter = SDL_free;
+    }
+    return true;
+}
+
+static bool DecodeImages(Data* data, const std::vector<ImagePaths>& image_paths)
+{
+    size_t num_images = image_paths.size();
+    data->images.resize(num_images);
+    data->image_keys.resize(num_images);
+    data->image_textures.resize(num_images);
+    std::vector<std::span<const uint8_t>> files(num_images);
+    std::vector<std::span<const uint8_t>> fallback_files(num_images);
+    for (size_t i = 0; i < num_images; i++)
+    {
+        files[i] = MapFile(data, image_paths[i].path);
+        if (!image_paths[i].fallback_path.empty())
         {
-            SDL_Log("Failed to create buffer: %s", SDL_GetError());
+            fallback_files[i] = MapFile(data, image_paths[i].fallback_path);
+        }
+        if (files[i].empty() && fallback_files[i].empty())
+        {
+            SDL_Log("Failed to open image: %s", image_paths[i].path.string().data());
             return false;
         }
     }
-    void* data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
-    if (!data)
+    std::vector<char> results(num_images);
+    std::vector<void(*)(void*)> deleters(num_images);
+    ParallelFor(num_images, [&](size_t i)
     {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
-        return false;
+        std::error_code error;
+        std::filesystem::path path = std::filesystem::weakly_canonical(image_paths[i].path, error);
+        std::string& key = data->image_keys[i];
+        key = (error ? image_paths[i].path : path).string() + ":" + std::to_string(Hash(files[i]));
+        if (!fallback_files[i].empty())
+        {
+            key += ":" + std::to_string(Hash(fallback_files[i]));
+        }
+        if (data->flags & SDLX_MODELFLAG_MIPMAPS)
+        {
+            key += ":mipmaps";
+        }
+        /* images already on the device are pinned until upload instead of decoded */
+        if (data->device && !(data->flags & SDLX_MODELFLAG_CACHE))
+        {
+            data->image_textures[i] = AcquireSharedTexture(data->device, key);
+        }
+        if (data->image_textures[i])
+        {
+            results[i] = true;
+            return;
+        }
+        results[i] = DecodeImageFile(data, files[i], data->images[i], deleters[i]) ||
+            (!fallback_files[i].empty() && DecodeImageFile(data, fallback_files[i], data->images[i], deleters[i]));
+    });
+    bool success = true;
+    for (size_t i = 0; i < num_images; i++)
+    {
+        if (!results[i])
+        {
+            success = false;
+        }
+        else if (data->images[i].pixels)
+        {
+            data->allocations.emplace_back(data->images[i].pixels, deleters[i]);
+        }
     }
-    if (primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+    return success;
+}
+
+/* levels are appended after the source indices, in the same element size */
+static bool DecodeLods(Data* data, const std::vector<char>& triangles)
+{
+    std::vector<std::vector<uint32_t>> indices(data->primitives.size());
+    ParallelFor(data->primitives.size(), [&](size_t i)
     {
-        uint16_t* u16_data = static_cast<uint16_t*>(data);
-        for (uint32_t i = 0; i < accessor->count; i++)
+        if (triangles[i])
         {
-            u16_data[i] = cgltf_accessor_read_index(accessor, i);
+            GenerateLods(data->primitives[i], indices[i]);
+        }
+    });
+    for (size_t i = 0; i < data->primitives.size(); i++)
+    {
+        SDLx_ModelPrimitiveData& primitive = data->primitives[i];
+        if (primitive.num_lods < 2)
+        {
+            continue;
+        }
+        if (primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            uint16_t* u16_data = data->Allocate<uint16_t>(indices[i].size());
+            if (!u16_data)
+            {
+                return false;
+            }
+            std::copy(indices[i].begin(), indices[i].end(), u16_data);
+            primitive.indices = u16_data;
+        }
+        else
+        {
+            uint32_t* u32_data = data->Allocate<uint32_t>(indices[i].size());
+            if (!u32_data)
+            {
+                return false;
+            }
+            std::copy(indices[i].begin(), indices[i].end(), u32_data);
+            primitive.indices = u32_data;
         }
+        primitive.num_indices = indices[i].size();
     }
-    else
+    return true;
+}
+
+/*
+ * Every level is reordered for the vertex cache and overdraw on its own, then
+ * the vertices are renumbered in the order the levels first use them, which
+ * drops the unused ones.
+ */
+static bool OptimizeGltf(Data* data, const std::vector<char>& triangles)
+{
+    std::vector<std::vector<uint32_t>> indices(data->primitives.size());
+    std::vector<std::vector<uint32_t>> orders(data->primitives.size());
+    std::vector<VertexCacheStats> source_stats(data->primitives.size());
+    std::vector<VertexCacheStats> stats(data->primitives.size());
+    ParallelFor(data->primitives.size(), [&](size_t i)
     {
-        uint32_t* u32_data = static_cast<uint32_t*>(data);
-        for (uint32_t i = 0; i < accessor->count; i++)
+        const SDLx_ModelPrimitiveData& primitive = data->primitives[i];
+        if (!triangles[i] || !primitive.positions || !primitive.indices || primitive.num_indices % 3)
         {
-            u32_data[i] = cgltf_accessor_read_index(accessor, i);
+            return;
+        }
+        indices[i].resize(primitive.num_indices);
+        for (uint32_t j = 0; j < primitive.num_indices; j++)
+        {
+            if (primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+            {
+                indices[i][j] = static_cast<const uint16_t*>(primitive.indices)[j];
+            }
+            else
+            {
+                indices[i][j] = static_cast<const uint32_t*>(primitive.indices)[j];
+            }
+            if (indices[i][j] >= primitive.num_vertices)
+            {
+                indices[i].clear();
+                return;
+            }
+        }
+        SDLx_ModelLod lod = {0, primitive.num_indices, 0.0f};
+        std::span<const SDLx_ModelLod> lods = primitive.num_lods ? std::span(primitive.lods, primitive.num_lods) : std::span(&lod, 1);
+        std::span<uint32_t> full(indices[i].data() + lods[0].first_index, lods[0].num_indices);
+        source_stats[i].Analyze(full, primitive.num_vertices);
+        for (const SDLx_ModelLod& level : lods)
+        {
+            OptimizeIndices(std::span(indices[i].data() + level.first_index, level.num_indices), primitive.positions, primitive.num_vertices);
         }
+        orders[i] = OptimizeVertexFetch(indices[i], primitive.num_vertices);
+        stats[i].Analyze(full, orders[i].size());
+    });
+    VertexCacheStats source_total{};
+    VertexCacheStats total{};
+    for (size_t i = 0; i < data->primitives.size(); i++)
+    {
+        SDLx_ModelPrimitiveData& primitive = data->primitives[i];
+        if (indices[i].empty())
+        {
+            continue;
+        }
+        source_total.Add(source_stats[i]);
+        total.Add(stats[i]);
+        const std::vector<uint32_t>& order = orders[i];
+        SDLx_ModelVec3* positions = data->Allocate<SDLx_ModelVec3>(order.size());
+        SDLx_ModelVec2* texcoords = primitive.texcoords ? data->Allocate<SDLx_ModelVec2>(order.size()) : nullptr;
+        SDLx_ModelVec3* normals = primitive.normals ? data->Allocate<SDLx_ModelVec3>(order.size()) : nullptr;
+        if (!positions || (primitive.texcoords && !texcoords) || (primitive.normals && !normals))
+        {
+            return false;
+        }
+        for (size_t j = 0; j < order.size(); j++)
+        {
+            positions[j] = primitive.positions[order[j]];
+            if (texcoords)
+            {
+                texcoords[j] = primitive.texcoords[order[j]];
+            }
+            if (normals)
+            {
+                normals[j] = primitive.normals[order[j]];
+            }
+        }
+        primitive.positions = positions;
+        primitive.texcoords = texcoords;
+        primitive.normals = normals;
+        primitive.num_vertices = order.size();
+        if (primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            uint16_t* u16_data = data->Allocate<uint16_t>(indices[i].size());
+            if (!u16_data)
+            {
+                return false;
+            }
+            std::copy(indices[i].begin(), indices[i].end(), u16_data);
+            primitive.indices = u16_data;
+        }
+        else
+        {
+            uint32_t* u32_data = data->Allocate<uint32_t>(indices[i].size());
+            if (!u32_data)
+            {
+                return false;
+            }
+            std::copy(indices[i].begin(), indices[i].end(), u32_data);
+            primitive.indices = u32_data;
+        }
+    }
+    data->source_index_stats = source_total.Get();
+    data->index_stats = total.Get();
+    return true;
+}
+
+static bool DecodeMeshlets(Data* data, const std::vector<char>& triangles)
+{
+    std::vector<std::vector<SDLx_ModelMeshlet>> meshlets(data->primitives.size());
+    std::vector<std::vector<uint32_t>> vertices(data->primitives.size());
+    std::vector<std::vector<uint32_t>> meshlet_triangles(data->primitives.size());
+    ParallelFor(data->primitives.size(), [&](size_t i)
+    {
+        if (triangles[i])
+        {
+            BuildMeshlets(data->primitives[i], meshlets[i], vertices[i], meshlet_triangles[i]);
+        }
+    });
+    for (size_t i = 0; i < data->primitives.size(); i++)
+    {
+        SDLx_ModelPrimitiveData& primitive = data->primitives[i];
+        if (meshlets[i].empty())
+        {
+            continue;
+        }
+        primitive.meshlets = data->Allocate<SDLx_ModelMeshlet>(meshlets[i].size());
+        primitive.meshlet_vertices = data->Allocate<Uint32>(vertices[i].size());
+        primitive.meshlet_triangles = data->Allocate<Uint32>(meshlet_triangles[i].size());
+        if (!primitive.meshlets || !primitive.meshlet_vertices || !primitive.meshlet_triangles)
+        {
+            return false;
+        }
+        std::copy(meshlets[i].begin(), meshlets[i].end(), primitive.meshlets);
+        std::copy(vertices[i].begin(), vertices[i].end(), primitive.meshlet_vertices);
+        std::copy(meshlet_triangles[i].begin(), meshlet_triangles[i].end(), primitive.meshlet_triangles);
+        primitive.num_meshlets = meshlets[i].size();
+        primitive.num_meshlet_vertices = vertices[i].size();
+        primitive.num_meshlet_triangles = meshlet_triangles[i].size();
     }
-    SDL_GPUTransferBufferLocation location{};
-    SDL_GPUBufferRegion region{};
-    location.transfer_buffer = transfer_buffer;
-    region.buffer = primitive.index_buffer;
-    region.size = accessor->count * stride;
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
     return true;
 }
 
-bool LoadGltf(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, std::filesystem::path& path)
+static cgltf_result ReadFile(const cgltf_memory_options* memory_options, const cgltf_file_options* file_options,
+    const char* path, cgltf_size* size, void** file_data)
+{
+    Data* data = static_cast<Data*>(file_options->user_data);
+    std::span<const uint8_t> file = MapFile(data, path);
+    if (file.empty())
+    {
+        return cgltf_result_file_not_found;
+    }
+    *size = file.size();
+    *file_data = const_cast<uint8_t*>(file.data());
+    return cgltf_result_success;
+}
+
+static void ReleaseFile(const cgltf_memory_options* memory_options, const cgltf_file_options* file_options, void* file_data)
+{
+    /* mappings are owned by the data so accessors can keep pointing into them */
+}
+
+static bool ParseGltf(Data* data, std::filesystem::path& path, cgltf_data*& src_data)
 {
     cgltf_options options{};
-    cgltf_data* data = nullptr;
-    if (cgltf_parse_file(&options, path.replace_extension(".gltf").string().data(), &data) &&
-        cgltf_parse_file(&options, path.replace_extension(".glb").string().data(), &data))
+    options.file.read = ReadFile;
+    options.file.release = ReleaseFile;
+    options.file.user_data = data;
+    return !cgltf_parse_file(&options, path.replace_extension(".gltf").string().data(), &src_data) ||
+           !cgltf_parse_file(&options, path.replace_extension(".glb").string().data(), &src_data);
+}
+
+bool HashGltf(Data* data, const std::filesystem::path& path, uint64_t& hash)
+{
+    std::filesystem::path source = path;
+    cgltf_data* src_data = nullptr;
+    if (!ParseGltf(data, source, src_data))
+    {
+        return false;
+    }
+    std::unique_ptr<cgltf_data, decltype(&cgltf_free)> handle(src_data, cgltf_free);
+    /* the json or glb itself (the last mapping), then every external buffer and image it names */
+    hash = Hash(0, data->mappings.back());
+    std::vector<const char*> uris;
+    for (int i = 0; i < src_data->buffers_count; i++)
+    {
+        uris.push_back(src_data->buffers[i].uri);
+    }
+    for (int i = 0; i < src_data->images_count; i++)
+    {
+        uris.push_back(src_data->images[i].uri);
+    }
+    for (const char* uri : uris)
+    {
+        if (!uri || !std::strncmp(uri, "data:", 5))
+        {
+            continue;
+        }
+        std::span<const uint8_t> file = MapFile(data, source.replace_filename(uri));
+        if (file.empty())
+        {
+            return false;
+        }
+        hash = Hash(hash, file);
+    }
+    return true;
+}
+
+bool DecodeGltf(Data* data, std::filesystem::path& path)
+{
+    cgltf_options options{};
+    options.file.read = ReadFile;
+    options.file.release = ReleaseFile;
+    options.file.user_data = data;
+    cgltf_data* src_data = nullptr;
+    if (!ParseGltf(data, path, src_data))
     {
         SDL_Log("Failed to parse gltf: %s", path.string().data());
         return false;
     }
-    if (cgltf_load_buffers(&options, data, path.string().data()))
+    std::unique_ptr<cgltf_data, decltype(&cgltf_free)> handle(src_data, cgltf_free);
+    if (cgltf_load_buffers(&options, src_data, path.string().data()))
     {
         SDL_Log("Failed to load buffers: %s", path.string().data());
         return false;
     }
-    model->gltf.num_meshes = data->meshes_count;
-    model->gltf.meshes = new SDLx_ModelMesh[model->gltf.num_meshes];
-    if (!model->gltf.meshes)
+    size_t num_primitives = 0;
+    for (int i = 0; i < src_data->meshes_count; i++)
     {
-        SDL_Log("Failed to create meshes");
-        return false;
+        num_primitives += src_data->meshes[i].primitives_count;
     }
-    for (int i = 0; i < model->gltf.num_meshes; i++)
+    data->meshes.resize(src_data->meshes_count);
+    data->primitives.resize(num_primitives);
+    std::vector<int> image_indices(src_data->images_count, -1);
+    std::vector<ImagePaths> image_paths;
+    std::vector<std::pair<SDLx_ModelVec3, SDLx_ModelVec3>> mesh_bounds(src_data->meshes_count, {data->min, data->max});
+    std::vector<char> triangles(data->primitives.size());
+    num_primitives = 0;
+    for (int i = 0; i < data->meshes.size(); i++)
     {
-        const cgltf_mesh& src_mesh = data->meshes[i];
-        SDLx_ModelMesh& mesh = model->gltf.meshes[i];
+        const cgltf_mesh& src_mesh = src_data->meshes[i];
+        SDLx_ModelMeshData& mesh = data->meshes[i];
         mesh.num_primitives = src_mesh.primitives_count;
-        mesh.primitives = new SDLx_ModelPrimitive[mesh.num_primitives];
-        std::memset(mesh.primitives, 0, mesh.num_primitives * sizeof(SDLx_ModelPrimitive));
-        if (!mesh.primitives)
-        {
-            SDL_Log("Failed to create primitives");
-            return false;
-        }
+        mesh.primitives = data->primitives.data() + num_primitives;
+        num_primitives += mesh.num_primitives;
         for (int j = 0; j < mesh.num_primitives; j++)
         {
             const cgltf_primitive& src_primitive = src_mesh.primitives[j];
-            SDLx_ModelPrimitive& primitive = mesh.primitives[j];
+            SDLx_ModelPrimitiveData& primitive = mesh.primitives[j];
+            primitive.color_image = -1;
+            primitive.normal_image = -1;
+            triangles[&primitive - data->primitives.data()] = src_primitive.type == cgltf_primitive_type_triangles;
             for (int k = 0; k < src_primitive.attributes_count; k++)
             {
                 const cgltf_attribute& attribute = src_primitive.attributes[k];
@@ -179,26 +529,38 @@ bool LoadGltf(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pa
                 switch (attribute.type)
                 {
                 case cgltf_attribute_type_position:
-                    primitive.position_buffer = CreateVertexBuffer<SDLx_ModelVec3>(device, copy_pass, accessor);
-                    if (!primitive.position_buffer)
+                    primitive.positions = ReadAttribute<SDLx_ModelVec3>(data, accessor);
+                    primitive.num_vertices = accessor->count;
+                    if (!primitive.positions)
                     {
-                        SDL_Log("Failed to create position buffer");
+                        SDL_Log("Failed to read positions");
                         return false;
                     }
+                    if (accessor->has_min && accessor->has_max)
+                    {
+                        SDLx_ModelVec3& min = mesh_bounds[i].first;
+                        SDLx_ModelVec3& max = mesh_bounds[i].second;
+                        min = {std::min(min.x, accessor->min[0]), std::min(min.y, accessor->min[1]), std::min(min.z, accessor->min[2])};
+                        max = {std::max(max.x, accessor->max[0]), std::max(max.y, accessor->max[1]), std::max(max.z, accessor->max[2])};
+                    }
+                    else
+                    {
+                        ComputeBounds(primitive.positions, primitive.num_vertices, sizeof(SDLx_ModelVec3), mesh_bounds[i].first, mesh_bounds[i].second);
+                    }
                     break;
                 case cgltf_attribute_type_texcoord:
-                    primitive.texcoord_buffer = CreateVertexBuffer<SDLx_ModelVec2>(device, copy_pass, accessor);
-                    if (!primitive.texcoord_buffer)
+                    primitive.texcoords = ReadAttribute<SDLx_ModelVec2>(data, accessor);
+                    if (!primitive.texcoords)
                     {
-                        SDL_Log("Failed to create texcoord buffer");
+                        SDL_Log("Failed to read texcoords");
                         return false;
                     }
                     break;
                 case cgltf_attribute_type_normal:
-                    primitive.normal_buffer = CreateVertexBuffer<SDLx_ModelVec3>(device, copy_pass, accessor);
-                    if (!primitive.normal_buffer)
+                    primitive.normals = ReadAttribute<SDLx_ModelVec3>(data, accessor);
+                    if (!primitive.normals)
                     {
-                        SDL_Log("Failed to create normal buffer");
+                        SDL_Log("Failed to read normals");
                         return false;
                     }
                     break;
@@ -207,9 +569,9 @@ bool LoadGltf(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pa
             const cgltf_accessor* accessor = src_primitive.indices;
             if (accessor)
             {
-                if (!CreateIndexBuffer(primitive, device, copy_pass, accessor))
+                if (!ReadIndices(primitive, data, accessor))
                 {
-                    SDL_Log("Failed to create index buffer");
+                    SDL_Log("Failed to read indices");
                     return false;
                 }
             }
@@ -219,121 +581,836 @@ bool LoadGltf(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pa
                 if (material->has_pbr_metallic_roughness)
                 {
                     const cgltf_texture_view& view = material->pbr_metallic_roughness.base_color_texture;
-                    if (view.texture && view.texture->image && view.texture->image->uri)
-                    {
-                        const cgltf_image* image = view.texture->image;
-                        path.replace_filename(image->uri);
-                        primitive.color_texture = LoadTexture(device, copy_pass, path);
-                        if (!primitive.color_texture)
-                        {
-                            SDL_Log("Failed to load color texture");
-                            return false;
-                        }
-                    }
+                    ReadImage(primitive.color_image, image_indices, image_paths, src_data, view, path);
                 }
                 const cgltf_texture_view& view = material->normal_texture;
-                if (view.texture && view.texture->image && view.texture->image->uri)
-                {
-                    cgltf_image* image = view.texture->image;
-                    path.replace_filename(image->uri);
-                    primitive.normal_texture = LoadTexture(device, copy_pass, path);
-                    if (!primitive.normal_texture)
-                    {
-                        SDL_Log("Failed to load color texture");
-                        return false;
-                    }
-                }
+                ReadImage(primitive.normal_image, image_indices, image_paths, src_data, view, path);
             }
-            if (!primitive.color_texture)
+        }
+    }
+    if ((data->flags & SDLX_MODELFLAG_LODS) && !DecodeLods(data, triangles))
+    {
+        SDL_Log("Failed to generate lods: %s", path.string().data());
+        return false;
+    }
+    if ((data->flags & SDLX_MODELFLAG_OPTIMIZE) && !OptimizeGltf(data, triangles))
+    {
+        SDL_Log("Failed to optimize: %s", path.string().data());
+        return false;
+    }
+    if ((data->flags & SDLX_MODELFLAG_MESHLETS) && !DecodeMeshlets(data, triangles))
+    {
+        SDL_Log("Failed to build meshlets: %s", path.string().data());
+        return false;
+    }
+    if (!DecodeImages(data, image_paths))
+    {
+        SDL_Log("Failed to load texture(s)");
+        return false;
+    }
+    for (int i = 0; i < src_data->nodes_count; i++)
+    {
+        const cgltf_node& src_node = src_data->nodes[i];
+        if (!src_node.mesh)
+        {
+            continue;
+        }
+        SDLx_ModelNodeData& node = data->nodes.emplace_back();
+        SDLx_ModelMatrix& transform = node.transform;
+        node.mesh = src_node.mesh - src_data->meshes;
+        cgltf_node_transform_world(&src_node, transform);
+        const SDLx_ModelVec3& local_min = mesh_bounds[node.mesh].first;
+        const SDLx_ModelVec3& local_max = mesh_bounds[node.mesh].second;
+        if (local_min.x > local_max.x)
+        {
+            continue;
+        }
+        /* transform the box as center and extents, the matrix being column-major */
+        float center[3] = {(local_min.x + local_max.x) * 0.5f, (local_min.y + local_max.y) * 0.5f, (local_min.z + local_max.z) * 0.5f};
+        float extent[3] = {(local_max.x - local_min.x) * 0.5f, (local_max.y - local_min.y) * 0.5f, (local_max.z - local_min.z) * 0.5f};
+        float world_min[3];
+        float world_max[3];
+        for (int r = 0; r < 3; r++)
+        {
+            float world_center = transform[12 + r];
+            float world_extent = 0.0f;
+            for (int c = 0; c < 3; c++)
             {
-                primitive.color_texture = Create1x1Texture(device, copy_pass, 0xFFFFFFFF);
-                if (!primitive.color_texture)
-                {
-                    SDL_Log("Failed to create color texture");
-                    return false;
-                }
+                world_center += transform[c * 4 + r] * center[c];
+                world_extent += std::abs(transform[c * 4 + r]) * extent[c];
             }
-            if (!primitive.normal_texture)
+            world_min[r] = world_center - world_extent;
+            world_max[r] = world_center + world_extent;
+        }
+        data->min.x = std::min(data->min.x, world_min[0]);
+        data->min.y = std::min(data->min.y, world_min[1]);
+        data->min.z = std::min(data->min.z, world_min[2]);
+        data->max.x = std::max(data->max.x, world_max[0]);
+        data->max.y = std::max(data->max.y, world_max[1]);
+        data->max.z = std::max(data->max.z, world_max[2]);
+    }
+    data->gltf.meshes = data->meshes.data();
+    data->gltf.num_meshes = data->meshes.size();
+    data->gltf.nodes = data->nodes.data();
+    data->gltf.num_nodes = data->nodes.size();
+    for (size_t i = 0; i < data->images.size(); i++)
+    {
+        data->images[i].key = data->image_keys[i].data();
+    }
+    data->gltf.images = data->images.data();
+    data->gltf.num_images = data->images.size();
+    return true;
+}
+
+static int16_t ToSnorm(float value)
+{
+    return int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static uint16_t ToUnorm(float value)
+{
+    return uint16_t(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+/* rounds to nearest even, out of range values become infinity */
+static uint16_t ToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    int exponent = int((bits >> 23) & 0xFF) - 127 + 15;
+    if (((bits >> 23) & 0xFF) == 0xFF)
+    {
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    }
+    if (exponent >= 31)
+    {
+        return sign | 0x7C00;
+    }
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        return sign | (half + (rest > halfway || (rest == halfway && (half & 1))));
+    }
+    uint32_t half = exponent << 10 | mantissa >> 13;
+    uint32_t rest = mantissa & 0x1FFF;
+    return sign | (half + (rest > 0x1000 || (rest == 0x1000 && (half & 1))));
+}
+
+/* octahedral, folding the lower hemisphere over the diagonals */
+static void EncodeNormal(const SDLx_ModelVec3& normal, int16_t encoded[2])
+{
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum <= 0.0f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    float x = normal.x / sum;
+    float y = normal.y / sum;
+    if (normal.z < 0.0f)
+    {
+        float folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+    encoded[0] = ToSnorm(x);
+    encoded[1] = ToSnorm(y);
+}
+
+static uint32_t GetFormatSize(SDL_GPUVertexElementFormat format)
+{
+    switch (format)
+    {
+    case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3:
+        return 12;
+    case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+static SDLx_ModelVertexLayout GetLayout(SDLx_ModelFlags flags)
+{
+    SDLx_ModelVertexLayout layout{};
+    if (flags & SDLX_MODELFLAG_QUANTIZE)
+    {
+        layout.position_format = SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM;
+        layout.texcoord_format = (flags & SDLX_MODELFLAG_UNORM_TEXCOORDS) ? SDL_GPU_VERTEXELEMENTFORMAT_USHORT2_NORM : SDL_GPU_VERTEXELEMENTFORMAT_HALF2;
+        layout.normal_format = SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM;
+        if (flags & SDLX_MODELFLAG_INTERLEAVE)
+        {
+            layout.stride = sizeof(SDLx_ModelGltfQuantizedVertex);
+            layout.position_offset = offsetof(SDLx_ModelGltfQuantizedVertex, position);
+            layout.texcoord_offset = offsetof(SDLx_ModelGltfQuantizedVertex, texcoord);
+            layout.normal_offset = offsetof(SDLx_ModelGltfQuantizedVertex, normal);
+        }
+        return layout;
+    }
+    layout.position_format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
+    layout.texcoord_format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
+    layout.normal_format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
+    if (flags & SDLX_MODELFLAG_INTERLEAVE)
+    {
+        layout.stride = sizeof(SDLx_ModelGltfVertex);
+        layout.position_offset = offsetof(SDLx_ModelGltfVertex, position);
+        layout.texcoord_offset = offsetof(SDLx_ModelGltfVertex, texcoord);
+        layout.normal_offset = offsetof(SDLx_ModelGltfVertex, normal);
+    }
+    return layout;
+}
+
+/* positions are mapped onto [-1, 1] by their bounds and texcoords onto [0, 1], each axis on its own */
+static void SetQuantization(SDLx_ModelFlags flags, const SDLx_ModelPrimitiveData& src_primitive, SDLx_ModelPrimitive& primitive)
+{
+    SDLx_ModelMatrix& transform = primitive.position_transform;
+    std::fill_n(transform, 16, 0.0f);
+    transform[0] = transform[5] = transform[10] = transform[15] = 1.0f;
+    primitive.texcoord_scale = {1.0f, 1.0f};
+    primitive.texcoord_bias = {0.0f, 0.0f};
+    if (!(flags & SDLX_MODELFLAG_QUANTIZE) || !src_primitive.positions || !src_primitive.num_vertices)
+    {
+        return;
+    }
+    float lowest = std::numeric_limits<float>::lowest();
+    float highest = std::numeric_limits<float>::max();
+    SDLx_ModelVec3 min = {highest, highest, highest};
+    SDLx_ModelVec3 max = {lowest, lowest, lowest};
+    ComputeBounds(src_primitive.positions, src_primitive.num_vertices, sizeof(SDLx_ModelVec3), min, max);
+    float extent[3] = {(max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f};
+    transform[0] = extent[0] > 0.0f ? extent[0] : 1.0f;
+    transform[5] = extent[1] > 0.0f ? extent[1] : 1.0f;
+    transform[10] = extent[2] > 0.0f ? extent[2] : 1.0f;
+    transform[12] = (min.x + max.x) * 0.5f;
+    transform[13] = (min.y + max.y) * 0.5f;
+    transform[14] = (min.z + max.z) * 0.5f;
+    if (!(flags & SDLX_MODELFLAG_UNORM_TEXCOORDS) || !src_primitive.texcoords)
+    {
+        return;
+    }
+    SDLx_ModelVec2 texcoord_min = src_primitive.texcoords[0];
+    SDLx_ModelVec2 texcoord_max = texcoord_min;
+    for (uint32_t i = 1; i < src_primitive.num_vertices; i++)
+    {
+        const SDLx_ModelVec2& texcoord = src_primitive.texcoords[i];
+        texcoord_min = {std::min(texcoord_min.x, texcoord.x), std::min(texcoord_min.y, texcoord.y)};
+        texcoord_max = {std::max(texcoord_max.x, texcoord.x), std::max(texcoord_max.y, texcoord.y)};
+    }
+    primitive.texcoord_scale.x = texcoord_max.x > texcoord_min.x ? texcoord_max.x - texcoord_min.x : 1.0f;
+    primitive.texcoord_scale.y = texcoord_max.y > texcoord_min.y ? texcoord_max.y - texcoord_min.y : 1.0f;
+    primitive.texcoord_bias = texcoord_min;
+}
+
+/*
+ * Writes every vertex of a primitive in the formats of the layout, each
+ * attribute to its own destination (skipped when null) and with the layout
+ * stride, or tightly packed without one. Missing attributes are zeroed.
+ */
+static void WriteVertices(const SDLx_ModelVertexLayout& layout, const SDLx_ModelPrimitiveData& src_primitive,
+    const SDLx_ModelPrimitive& primitive, uint8_t* positions, uint8_t* texcoords, uint8_t* normals)
+{
+    uint32_t position_stride = layout.stride ? layout.stride : GetFormatSize(layout.position_format);
+    uint32_t texcoord_stride = layout.stride ? layout.stride : GetFormatSize(layout.texcoord_format);
+    uint32_t normal_stride = layout.stride ? layout.stride : GetFormatSize(layout.normal_format);
+    const SDLx_ModelMatrix& transform = primitive.position_transform;
+    for (uint32_t i = 0; i < src_primitive.num_vertices && positions; i++)
+    {
+        const SDLx_ModelVec3& position = src_primitive.positions[i];
+        uint8_t* dst_data = positions + i * position_stride;
+        if (layout.position_format == SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3)
+        {
+            std::memcpy(dst_data, &position, sizeof(position));
+            continue;
+        }
+        int16_t quantized[4] =
+        {
+            ToSnorm((position.x - transform[12]) / transform[0]),
+            ToSnorm((position.y - transform[13]) / transform[5]),
+            ToSnorm((position.z - transform[14]) / transform[10]),
+            32767,
+        };
+        std::memcpy(dst_data, quantized, sizeof(quantized));
+    }
+    for (uint32_t i = 0; i < src_primitive.num_vertices && texcoords; i++)
+    {
+        SDLx_ModelVec2 texcoord = src_primitive.texcoords ? src_primitive.texcoords[i] : SDLx_ModelVec2{};
+        uint8_t* dst_data = texcoords + i * texcoord_stride;
+        uint16_t quantized[2];
+        switch (layout.texcoord_format)
+        {
+        case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2:
+            std::memcpy(dst_data, &texcoord, sizeof(texcoord));
+            continue;
+        case SDL_GPU_VERTEXELEMENTFORMAT_HALF2:
+            quantized[0] = ToHalf(texcoord.x);
+            quantized[1] = ToHalf(texcoord.y);
+            break;
+        default:
+            quantized[0] = ToUnorm((texcoord.x - primitive.texcoord_bias.x) / primitive.texcoord_scale.x);
+            quantized[1] = ToUnorm((texcoord.y - primitive.texcoord_bias.y) / primitive.texcoord_scale.y);
+            break;
+        }
+        std::memcpy(dst_data, quantized, sizeof(quantized));
+    }
+    for (uint32_t i = 0; i < src_primitive.num_vertices && normals; i++)
+    {
+        SDLx_ModelVec3 normal = src_primitive.normals ? src_primitive.normals[i] : SDLx_ModelVec3{};
+        uint8_t* dst_data = normals + i * normal_stride;
+        if (layout.normal_format == SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3)
+        {
+            std::memcpy(dst_data, &normal, sizeof(normal));
+            continue;
+        }
+        int16_t encoded[2];
+        EncodeNormal(normal, encoded);
+        std::memcpy(dst_data, encoded, sizeof(encoded));
+    }
+}
+
+static bool CreateBuffers(Model* model, Staging& staging, const SDLx_ModelVertexLayout& layout,
+    const SDLx_ModelPrimitiveData& src_primitive, SDLx_ModelPrimitive& primitive)
+{
+    if (layout.stride)
+    {
+        if (src_primitive.positions)
+        {
+            uint32_t size = src_primitive.num_vertices * layout.stride;
+            primitive.vertex_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_VERTEX, size, [layout, &src_primitive, &primitive](void* dst_data)
             {
-                primitive.normal_texture = Create1x1Texture(device, copy_pass, 0x01010101);
-                if (!primitive.normal_texture)
-                {
-                    SDL_Log("Failed to create normal texture");
-                    return false;
-                }
+                uint8_t* vertex_data = static_cast<uint8_t*>(dst_data);
+                WriteVertices(layout, src_primitive, primitive, vertex_data + layout.position_offset,
+                    vertex_data + layout.texcoord_offset, vertex_data + layout.normal_offset);
+            });
+            if (!primitive.vertex_buffer)
+            {
+                SDL_Log("Failed to create vertex buffer");
+                return false;
             }
+            model->buffers.push_back(primitive.vertex_buffer);
         }
     }
-    model->gltf.num_nodes = 0;
-    for (int i = 0; i < data->nodes_count; i++)
+    else if (src_primitive.positions)
     {
-        const cgltf_node& src_node = data->nodes[i];
-        if (src_node.mesh)
+        uint32_t size = src_primitive.num_vertices * GetFormatSize(layout.position_format);
+        primitive.position_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_VERTEX, size, [layout, &src_primitive, &primitive](void* dst_data)
         {
-            model->gltf.num_nodes++;
+            WriteVertices(layout, src_primitive, primitive, static_cast<uint8_t*>(dst_data), nullptr, nullptr);
+        });
+        if (!primitive.position_buffer)
+        {
+            SDL_Log("Failed to create position buffer");
+            return false;
         }
+        model->buffers.push_back(primitive.position_buffer);
     }
-    model->gltf.nodes = new SDLx_ModelNode[model->gltf.num_nodes];
-    if (!model->gltf.nodes)
+    if (src_primitive.texcoords && !layout.stride)
     {
-        SDL_Log("Failed to create nodes");
-        return false;
+        uint32_t size = src_primitive.num_vertices * GetFormatSize(layout.texcoord_format);
+        primitive.texcoord_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_VERTEX, size, [layout, &src_primitive, &primitive](void* dst_data)
+        {
+            WriteVertices(layout, src_primitive, primitive, nullptr, static_cast<uint8_t*>(dst_data), nullptr);
+        });
+        if (!primitive.texcoord_buffer)
+        {
+            SDL_Log("Failed to create texcoord buffer");
+            return false;
+        }
+        model->buffers.push_back(primitive.texcoord_buffer);
     }
-    model->gltf.num_nodes = 0;
-    for (int i = 0; i < data->nodes_count; i++)
+    if (src_primitive.normals && !layout.stride)
     {
-        const cgltf_node& src_node = data->nodes[i];
-        if (!src_node.mesh)
+        uint32_t size = src_primitive.num_vertices * GetFormatSize(layout.normal_format);
+        primitive.normal_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_VERTEX, size, [layout, &src_primitive, &primitive](void* dst_data)
         {
-            continue;
+            WriteVertices(layout, src_primitive, primitive, nullptr, nullptr, static_cast<uint8_t*>(dst_data));
+        });
+        if (!primitive.normal_buffer)
+        {
+            SDL_Log("Failed to create normal buffer");
+            return false;
         }
-        SDLx_ModelNode& node = model->gltf.nodes[model->gltf.num_nodes++];
-        SDLx_ModelMatrix& transform = node.transform;
-        node.mesh = &model->gltf.meshes[src_node.mesh - data->meshes];
-        cgltf_node_transform_world(&src_node, transform);
-        const cgltf_mesh* src_mesh = src_node.mesh;
-        for (int j = 0; j < src_mesh->primitives_count; j++)
+        model->buffers.push_back(primitive.normal_buffer);
+    }
+    if (src_primitive.indices)
+    {
+        uint32_t stride = src_primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+        uint32_t size = src_primitive.num_indices * stride;
+        primitive.index_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_INDEX, src_primitive.indices, size);
+        if (!primitive.index_buffer)
+        {
+            SDL_Log("Failed to create index buffer");
+            return false;
+        }
+        model->buffers.push_back(primitive.index_buffer);
+        primitive.num_indices = src_primitive.num_lods ? src_primitive.lods[0].num_indices : src_primitive.num_indices;
+        primitive.index_element_size = src_primitive.index_element_size;
+        std::copy_n(src_primitive.lods, src_primitive.num_lods, primitive.lods);
+        primitive.num_lods = src_primitive.num_lods;
+    }
+    return true;
+}
+
+static bool CreatePackedBuffers(Model* model, Staging& staging, const SDLx_ModelData* data)
+{
+    const SDLx_ModelGltfData& src_gltf = data->gltf;
+    uint32_t num_vertices = 0;
+    uint32_t num_indices = 0;
+    SDL_GPUIndexElementSize index_element_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+    for (int i = 0; i < src_gltf.num_meshes; i++)
+    {
+        const SDLx_ModelMeshData& src_mesh = src_gltf.meshes[i];
+        SDLx_ModelMesh& mesh = model->meshes[i];
+        for (int j = 0; j < src_mesh.num_primitives; j++)
+        {
+            const SDLx_ModelPrimitiveData& src_primitive = src_mesh.primitives[j];
+            SDLx_ModelPrimitive& primitive = mesh.primitives[j];
+            if (!src_primitive.positions)
+            {
+                continue;
+            }
+            primitive.vertex_offset = num_vertices;
+            num_vertices += src_primitive.num_vertices;
+            if (!src_primitive.indices)
+            {
+                continue;
+            }
+            primitive.first_index = num_indices;
+            primitive.num_indices = src_primitive.num_lods ? src_primitive.lods[0].num_indices : src_primitive.num_indices;
+            for (int k = 0; k < src_primitive.num_lods; k++)
+            {
+                primitive.lods[k] = src_primitive.lods[k];
+                primitive.lods[k].first_index += num_indices;
+            }
+            primitive.num_lods = src_primitive.num_lods;
+            num_indices += src_primitive.num_indices;
+            if (src_primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_32BIT)
+            {
+                index_element_size = SDL_GPU_INDEXELEMENTSIZE_32BIT;
+            }
+        }
+    }
+    if (!num_vertices)
+    {
+        return true;
+    }
+    const SDLx_ModelVertexLayout& layout = model->gltf.layout;
+    uint32_t texcoord_offset = 0;
+    uint32_t normal_offset = 0;
+    uint32_t vertex_size;
+    if (layout.stride)
+    {
+        vertex_size = num_vertices * layout.stride;
+    }
+    else
+    {
+        texcoord_offset = (num_vertices * GetFormatSize(layout.position_format) + BufferAlignment - 1) / BufferAlignment * BufferAlignment;
+        normal_offset = (texcoord_offset + num_vertices * GetFormatSize(layout.texcoord_format) + BufferAlignment - 1) / BufferAlignment * BufferAlignment;
+        vertex_size = normal_offset + num_vertices * GetFormatSize(layout.normal_format);
+    }
+    SDL_GPUBuffer* vertex_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_VERTEX, vertex_size,
+        [model, &src_gltf, layout, texcoord_offset, normal_offset](void* dst_data)
+    {
+        uint8_t* vertex_data = static_cast<uint8_t*>(dst_data);
+        uint32_t base = 0;
+        for (int i = 0; i < src_gltf.num_meshes; i++)
         {
-            const cgltf_primitive* primitive = &src_mesh->primitives[j];
-            for (int k = 0; k < primitive->attributes_count; k++)
+            for (int j = 0; j < src_gltf.meshes[i].num_primitives; j++)
             {
-                const cgltf_attribute* attribute = &primitive->attributes[k];
-                if (attribute->type != cgltf_attribute_type_position)
+                const SDLx_ModelPrimitiveData& src_primitive = src_gltf.meshes[i].primitives[j];
+                const SDLx_ModelPrimitive& primitive = model->meshes[i].primitives[j];
+                if (!src_primitive.positions)
                 {
                     continue;
                 }
-                const cgltf_accessor* accessor = attribute->data;
-                if (!accessor->has_min || !accessor->has_max)
+                if (layout.stride)
                 {
-                    continue;
+                    uint8_t* vertices = vertex_data + base * layout.stride;
+                    WriteVertices(layout, src_primitive, primitive, vertices + layout.position_offset,
+                        vertices + layout.texcoord_offset, vertices + layout.normal_offset);
                 }
-                for (int l = 0; l < 8; l++)
+                else
                 {
-                    float world_bounds[4]{};
-                    float local_bounds[4] =
+                    WriteVertices(layout, src_primitive, primitive,
+                        vertex_data + base * GetFormatSize(layout.position_format),
+                        vertex_data + texcoord_offset + base * GetFormatSize(layout.texcoord_format),
+                        vertex_data + normal_offset + base * GetFormatSize(layout.normal_format));
+                }
+                base += src_primitive.num_vertices;
+            }
+        }
+    });
+    if (!vertex_buffer)
+    {
+        SDL_Log("Failed to create vertex buffer");
+        return false;
+    }
+    model->buffers.push_back(vertex_buffer);
+    SDL_GPUBuffer* index_buffer = nullptr;
+    if (num_indices)
+    {
+        uint32_t stride = index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+        index_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_INDEX, num_indices * stride,
+            [&src_gltf, index_element_size](void* dst_data)
+        {
+            uint16_t* u16_data = static_cast<uint16_t*>(dst_data);
+            uint32_t* u32_data = static_cast<uint32_t*>(dst_data);
+            for (int i = 0; i < src_gltf.num_meshes; i++)
+            {
+                for (int j = 0; j < src_gltf.meshes[i].num_primitives; j++)
+                {
+                    const SDLx_ModelPrimitiveData& src_primitive = src_gltf.meshes[i].primitives[j];
+                    if (!src_primitive.positions || !src_primitive.indices)
+                    {
+                        continue;
+                    }
+                    if (index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
                     {
-                        (l & 1) ? accessor->max[0] : accessor->min[0],
-                        (l & 2) ? accessor->max[1] : accessor->min[1],
-                        (l & 4) ? accessor->max[2] : accessor->min[2],
-                        1.0f
-                    };
-                    for (int r = 0; r < 4; r++)
+                        std::memcpy(u16_data, src_primitive.indices, src_primitive.num_indices * 2);
+                        u16_data += src_primitive.num_indices;
+                    }
+                    else if (src_primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_32BIT)
+                    {
+                        std::memcpy(u32_data, src_primitive.indices, src_primitive.num_indices * 4);
+                        u32_data += src_primitive.num_indices;
+                    }
+                    else
                     {
-                        for (int c = 0; c < 4; c++)
+                        const uint16_t* src_data = static_cast<const uint16_t*>(src_primitive.indices);
+                        for (uint32_t k = 0; k < src_primitive.num_indices; k++)
                         {
-                            world_bounds[r] += transform[r * 4 + c] * local_bounds[c];
+                            *u32_data++ = src_data[k];
                         }
                     }
-                    model->min.x = std::min(model->min.x, world_bounds[0]);
-                    model->min.y = std::min(model->min.y, world_bounds[1]);
-                    model->min.z = std::min(model->min.z, world_bounds[2]);
-                    model->max.x = std::max(model->max.x, world_bounds[0]);
-                    model->max.y = std::max(model->max.y, world_bounds[1]);
-                    model->max.z = std::max(model->max.z, world_bounds[2]);
                 }
             }
+        });
+        if (!index_buffer)
+        {
+            SDL_Log("Failed to create index buffer");
+            return false;
+        }
+        model->buffers.push_back(index_buffer);
+    }
+    for (int i = 0; i < src_gltf.num_meshes; i++)
+    {
+        const SDLx_ModelMeshData& src_mesh = src_gltf.meshes[i];
+        SDLx_ModelMesh& mesh = model->meshes[i];
+        for (int j = 0; j < src_mesh.num_primitives; j++)
+        {
+            const SDLx_ModelPrimitiveData& src_primitive = src_mesh.primitives[j];
+            SDLx_ModelPrimitive& primitive = mesh.primitives[j];
+            if (!src_primitive.positions)
+            {
+                continue;
+            }
+            if (data->flags & SDLX_MODELFLAG_INTERLEAVE)
+            {
+                primitive.vertex_buffer = vertex_buffer;
+            }
+            else
+            {
+                primitive.position_buffer = vertex_buffer;
+                primitive.texcoord_buffer = vertex_buffer;
+                primitive.normal_buffer = vertex_buffer;
+                primitive.position_buffer_offset = 0;
+                primitive.texcoord_buffer_offset = texcoord_offset;
+                primitive.normal_buffer_offset = normal_offset;
+            }
+            if (src_primitive.indices)
+            {
+                primitive.index_buffer = index_buffer;
+                primitive.index_element_size = index_element_size;
+            }
+        }
+    }
+    return true;
+}
+
+/* meshlets of every primitive are kept on the CPU too, rebased into the packed buffers with SDLX_MODELFLAG_PACK */
+static bool CreateMeshletBuffers(Model* model, Staging& staging, const SDLx_ModelData* data)
+{
+    static constexpr SDL_GPUBufferUsageFlags Usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ;
+    const SDLx_ModelGltfData& src_gltf = data->gltf;
+    bool pack = data->flags & SDLX_MODELFLAG_PACK;
+    uint32_t num_meshlets = 0;
+    uint32_t num_vertices = 0;
+    uint32_t num_triangles = 0;
+    for (int i = 0; i < src_gltf.num_meshes; i++)
+    {
+        for (int j = 0; j < src_gltf.meshes[i].num_primitives; j++)
+        {
+            const SDLx_ModelPrimitiveData& src_primitive = src_gltf.meshes[i].primitives[j];
+            num_meshlets += src_primitive.num_meshlets;
+        }
+    }
+    if (!num_meshlets)
+    {
+        return true;
+    }
+    model->meshlets.resize(num_meshlets);
+    num_meshlets = 0;
+    for (int i = 0; i < src_gltf.num_meshes; i++)
+    {
+        const SDLx_ModelMeshData& src_mesh = src_gltf.meshes[i];
+        SDLx_ModelMesh& mesh = model->meshes[i];
+        for (int j = 0; j < src_mesh.num_primitives; j++)
+        {
+            const SDLx_ModelPrimitiveData& src_primitive = src_mesh.primitives[j];
+            SDLx_ModelPrimitive& primitive = mesh.primitives[j];
+            if (!src_primitive.num_meshlets)
+            {
+                continue;
+            }
+            SDLx_ModelMeshlet* meshlets = model->meshlets.data() + num_meshlets;
+            std::copy_n(src_primitive.meshlets, src_primitive.num_meshlets, meshlets);
+            primitive.meshlets = meshlets;
+            primitive.num_meshlets = src_primitive.num_meshlets;
+            if (pack)
+            {
+                for (uint32_t k = 0; k < src_primitive.num_meshlets; k++)
+                {
+                    meshlets[k].first_vertex += num_vertices;
+                    meshlets[k].first_triangle += num_triangles;
+                }
+                primitive.first_meshlet = num_meshlets;
+                num_meshlets += src_primitive.num_meshlets;
+                num_vertices += src_primitive.num_meshlet_vertices;
+                num_triangles += src_primitive.num_meshlet_triangles;
+                continue;
+            }
+            num_meshlets += src_primitive.num_meshlets;
+            primitive.meshlet_buffer = CreateBuffer(staging, Usage, meshlets, src_primitive.num_meshlets * sizeof(SDLx_ModelMeshlet));
+            if (!primitive.meshlet_buffer)
+            {
+                SDL_Log("Failed to create meshlet buffer");
+                return false;
+            }
+            model->buffers.push_back(primitive.meshlet_buffer);
+            primitive.meshlet_vertex_buffer = CreateBuffer(staging, Usage, src_primitive.meshlet_vertices, src_primitive.num_meshlet_vertices * sizeof(Uint32));
+            if (!primitive.meshlet_vertex_buffer)
+            {
+                SDL_Log("Failed to create meshlet vertex buffer");
+                return false;
+            }
+            model->buffers.push_back(primitive.meshlet_vertex_buffer);
+            primitive.meshlet_triangle_buffer = CreateBuffer(staging, Usage, src_primitive.meshlet_triangles, src_primitive.num_meshlet_triangles * sizeof(Uint32));
+            if (!primitive.meshlet_triangle_buffer)
+            {
+                SDL_Log("Failed to create meshlet triangle buffer");
+                return false;
+            }
+            model->buffers.push_back(primitive.meshlet_triangle_buffer);
+        }
+    }
+    if (!pack)
+    {
+        return true;
+    }
+    SDL_GPUBuffer* meshlet_buffer = CreateBuffer(staging, Usage, model->meshlets.data(), num_meshlets * sizeof(SDLx_ModelMeshlet));
+    if (!meshlet_buffer)
+    {
+        SDL_Log("Failed to create meshlet buffer");
+        return false;
+    }
+    model->buffers.push_back(meshlet_buffer);
+    auto write = [&src_gltf](Uint32* dst_data, bool vertices)
+    {
+        for (int i = 0; i < src_gltf.num_meshes; i++)
+        {
+            for (int j = 0; j < src_gltf.meshes[i].num_primitives; j++)
+            {
+                const SDLx_ModelPrimitiveData& src_primitive = src_gltf.meshes[i].primitives[j];
+                if (vertices)
+                {
+                    dst_data = std::copy_n(src_primitive.meshlet_vertices, src_primitive.num_meshlet_vertices, dst_data);
+                }
+                else
+                {
+                    dst_data = std::copy_n(src_primitive.meshlet_triangles, src_primitive.num_meshlet_triangles, dst_data);
+                }
+            }
+        }
+    };
+    SDL_GPUBuffer* meshlet_vertex_buffer = CreateBuffer(staging, Usage, num_vertices * sizeof(Uint32), [write](void* dst_data)
+    {
+        write(static_cast<Uint32*>(dst_data), true);
+    });
+    if (!meshlet_vertex_buffer)
+    {
+        SDL_Log("Failed to create meshlet vertex buffer");
+        return false;
+    }
+    model->buffers.push_back(meshlet_vertex_buffer);
+    SDL_GPUBuffer* meshlet_triangle_buffer = CreateBuffer(staging, Usage, num_triangles * sizeof(Uint32), [write](void* dst_data)
+    {
+        write(static_cast<Uint32*>(dst_data), false);
+    });
+    if (!meshlet_triangle_buffer)
+    {
+        SDL_Log("Failed to create meshlet triangle buffer");
+        return false;
+    }
+    model->buffers.push_back(meshlet_triangle_buffer);
+    for (SDLx_ModelPrimitive& primitive : model->primitives)
+    {
+        if (primitive.num_meshlets)
+        {
+            primitive.meshlet_buffer = meshlet_buffer;
+            primitive.meshlet_vertex_buffer = meshlet_vertex_buffer;
+            primitive.meshlet_triangle_buffer = meshlet_triangle_buffer;
+        }
+    }
+    return true;
+}
+
+static SDL_GPUTexture* GetImageTexture(Model* model, Staging& staging, const SDLx_ModelImage& image)
+{
+    SDL_GPUTexture* texture = image.key ? AcquireStagedTexture(model, staging, image.key) : nullptr;
+    if (texture)
+    {
+        return texture;
+    }
+    if (!image.pixels)
+    {
+        SDL_Log("Missing image: %s", image.key ? image.key : "");
+        return nullptr;
+    }
+    texture = CreateTexture(staging, image);
+    if (!texture)
+    {
+        return nullptr;
+    }
+    if (image.key)
+    {
+        StageSharedTexture(model, staging, image.key, texture);
+    }
+    else
+    {
+        model->textures.push_back(texture);
+    }
+    return texture;
+}
+
+static SDL_GPUTexture* GetTexture(Model* model, Staging& staging,
+    const std::vector<SDL_GPUTexture*>& textures, SDL_GPUTexture*& default_texture, int index, uint32_t color)
+{
+    if (index >= 0 && index < textures.size() && textures[index])
+    {
+        return textures[index];
+    }
+    if (!default_texture)
+    {
+        default_texture = AcquireDefaultTexture(model, staging, color);
+        if (!default_texture)
+        {
+            SDL_Log("Failed to create 1x1 texture");
+            return nullptr;
+        }
+    }
+    return default_texture;
+}
+
+bool UploadGltf(Model* model, Staging& staging, const SDLx_ModelData* data)
+{
+    const SDLx_ModelGltfData& src_gltf = data->gltf;
+    std::vector<SDL_GPUTexture*> textures(src_gltf.num_images);
+    for (int i = 0; i < src_gltf.num_images; i++)
+    {
+        const SDLx_ModelImage& image = src_gltf.images[i];
+        if (image.pixels && !IsTextureSupported(staging.device, image))
+        {
+            /* primitives fall back to the default textures */
+            SDL_Log("Unsupported texture format: %d", image.format);
+            continue;
+        }
+        textures[i] = GetImageTexture(model, staging, image);
+        if (!textures[i])
+        {
+            SDL_Log("Failed to create texture");
+            return false;
+        }
+    }
+    SDL_GPUTexture* white_texture = nullptr;
+    SDL_GPUTexture* normal_texture = nullptr;
+    size_t num_primitives = 0;
+    for (int i = 0; i < src_gltf.num_meshes; i++)
+    {
+        num_primitives += src_gltf.meshes[i].num_primitives;
+    }
+    model->meshes.resize(src_gltf.num_meshes);
+    model->primitives.resize(num_primitives);
+    model->gltf.layout = GetLayout(data->flags);
+    num_primitives = 0;
+    for (int i = 0; i < src_gltf.num_meshes; i++)
+    {
+        const SDLx_ModelMeshData& src_mesh = src_gltf.meshes[i];
+        SDLx_ModelMesh& mesh = model->meshes[i];
+        mesh.num_primitives = src_mesh.num_primitives;
+        mesh.primitives = model->primitives.data() + num_primitives;
+        num_primitives += mesh.num_primitives;
+        for (int j = 0; j < mesh.num_primitives; j++)
+        {
+            const SDLx_ModelPrimitiveData& src_primitive = src_mesh.primitives[j];
+            SDLx_ModelPrimitive& primitive = mesh.primitives[j];
+            SetQuantization(data->flags, src_primitive, primitive);
+            if (!(data->flags & SDLX_MODELFLAG_PACK) && !CreateBuffers(model, staging, model->gltf.layout, src_primitive, primitive))
+            {
+                SDL_Log("Failed to create buffer(s)");
+                return false;
+            }
+            primitive.color_texture = GetTexture(model, staging, textures, white_texture, src_primitive.color_image, 0xFFFFFFFF);
+            if (!primitive.color_texture)
+            {
+                SDL_Log("Failed to create color texture");
+                return false;
+            }
+            primitive.normal_texture = GetTexture(model, staging, textures, normal_texture, src_primitive.normal_image, 0x01010101);
+            if (!primitive.normal_texture)
+            {
+                SDL_Log("Failed to create normal texture");
+                return false;
+            }
+        }
+    }
+    if ((data->flags & SDLX_MODELFLAG_PACK) && !CreatePackedBuffers(model, staging, data))
+    {
+        SDL_Log("Failed to create packed buffer(s)");
+        return false;
+    }
+    if (!CreateMeshletBuffers(model, staging, data))
+    {
+        SDL_Log("Failed to create meshlet buffer(s)");
+        return false;
+    }
+    model->nodes.resize(src_gltf.num_nodes);
+    for (int i = 0; i < src_gltf.num_nodes; i++)
+    {
+        const SDLx_ModelNodeData& src_node = src_gltf.nodes[i];
+        SDLx_ModelNode& node = model->nodes[i];
+        if (src_node.mesh < 0 || src_node.mesh >= src_gltf.num_meshes)
+        {
+            SDL_Log("Invalid node mesh: %d", src_node.mesh);
+            return false;
         }
+        node.mesh = &model->meshes[src_node.mesh];
+        std::memcpy(node.transform, src_node.transform, sizeof(SDLx_ModelMatrix));
     }
-    cgltf_free(data);
+    model->gltf.meshes = model->meshes.data();
+    model->gltf.num_meshes = model->meshes.size();
+    model->gltf.nodes = model->nodes.data();
+    model->gltf.num_nodes = model->nodes.size();
     return true;
 }
\ No newline at end of file
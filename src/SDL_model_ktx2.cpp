@@ -0,0 +1,256 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "internal.hpp"
+
+struct Format
+{
+    uint32_t vk_format;
+    SDL_GPUTextureFormat format;
+    int block_size;
+    bool flippable;
+};
+
+/* sRGB variants load as UNORM like the stb_image path so both look the same */
+static const Format Formats[] =
+{
+    {37,  SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, 1, true},
+    {43,  SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, 1, true},
+    {131, SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM, 4, true},
+    {132, SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM, 4, true},
+    {133, SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM, 4, true},
+    {134, SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM, 4, true},
+    {135, SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM, 4, true},
+    {136, SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM, 4, true},
+    {137, SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM, 4, true},
+    {138, SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM, 4, true},
+    {139, SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM,    4, true},
+    {141, SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM,   4, true},
+    {145, SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM, 4, false},
+    {146, SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM, 4, false},
+    {157, SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM, 4, false},
+    {158, SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM, 4, false},
+};
+
+template<typename T>
+static T Read(std::span<const uint8_t> span, size_t offset)
+{
+    T data{};
+    if (offset + sizeof(data) <= span.size())
+    {
+        std::memcpy(&data, span.data() + offset, sizeof(data));
+    }
+    return data;
+}
+
+static bool IsBottomUp(std::span<const uint8_t> file, uint32_t kvd_offset, uint32_t kvd_size)
+{
+    if (uint64_t(kvd_offset) + kvd_size > file.size())
+    {
+        return false;
+    }
+    std::span<const uint8_t> kvd = file.subspan(kvd_offset, kvd_size);
+    while (kvd.size() >= 4)
+    {
+        uint32_t size = Read<uint32_t>(kvd, 0);
+        if (size > kvd.size() - 4)
+        {
+            break;
+        }
+        std::string_view entry(reinterpret_cast<const char*>(kvd.data() + 4), size);
+        if (entry.starts_with(std::string_view("KTXorientation\0", 15)))
+        {
+            return entry.substr(15).starts_with("ru");
+        }
+        kvd = kvd.subspan(std::min<size_t>(kvd.size(), 4 + (size + 3) / 4 * 4));
+    }
+    return false;
+}
+
+static void FlipIndexRows(uint8_t* rows, int row_size, int height)
+{
+    /* rows of a 4x4 block, packed row_size bits each, reversed within the first height rows */
+    uint64_t bits = 0;
+    std::memcpy(&bits, rows, row_size / 2);
+    uint64_t flipped = bits;
+    uint64_t mask = (uint64_t(1) << row_size) - 1;
+    for (int y = 0; y < height; y++)
+    {
+        flipped &= ~(mask << (y * row_size));
+        flipped |= ((bits >> ((height - 1 - y) * row_size)) & mask) << (y * row_size);
+    }
+    std::memcpy(rows, &flipped, row_size / 2);
+}
+
+static void FlipBlock(SDL_GPUTextureFormat format, uint8_t* block, int height)
+{
+    switch (format)
+    {
+    case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+        FlipIndexRows(block + 4, 8, height);
+        break;
+    case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:
+        FlipIndexRows(block, 16, height);
+        FlipIndexRows(block + 12, 8, height);
+        break;
+    case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+        FlipIndexRows(block + 2, 12, height);
+        FlipIndexRows(block + 12, 8, height);
+        break;
+    case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+        FlipIndexRows(block + 2, 12, height);
+        break;
+    case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:
+        FlipIndexRows(block + 2, 12, height);
+        FlipIndexRows(block + 10, 12, height);
+        break;
+    }
+}
+
+static bool FlipLevel(const Format& format, uint8_t* data, uint32_t width, uint32_t height, uint32_t size)
+{
+    /* the stb_image path loads bottom-up, so block rows are flipped to match */
+    uint32_t num_rows = (height + format.block_size - 1) / format.block_size;
+    uint32_t row_size = size / num_rows;
+    if (format.block_size > 1 && height > 4 && height % 4)
+    {
+        /* partial blocks would shift the image by the padding */
+        return false;
+    }
+    for (uint32_t y = 0; y < num_rows / 2; y++)
+    {
+        std::swap_ranges(data + y * row_size, data + (y + 1) * row_size, data + (num_rows - 1 - y) * row_size);
+    }
+    if (format.block_size > 1)
+    {
+        int block_height = std::min<uint32_t>(height, 4);
+        uint32_t block_bytes = SDL_CalculateGPUTextureFormatSize(format.format, 4, 4, 1);
+        for (uint32_t offset = 0; offset < size; offset += block_bytes)
+        {
+            FlipBlock(format.format, data + offset, block_height);
+        }
+    }
+    return true;
+}
+
+static bool DecodeBasisLzLevels(std::span<const uint8_t> file, uint32_t width, uint32_t height, uint32_t num_levels, bool flip, SDLx_ModelImage& image)
+{
+    uint64_t global_offset = Read<uint64_t>(file, 64);
+    uint64_t global_size = Read<uint64_t>(file, 72);
+    if (global_offset > file.size() || global_size > file.size() - global_offset)
+    {
+        SDL_Log("Invalid ktx2 global data");
+        return false;
+    }
+    std::vector<std::span<const uint8_t>> levels(num_levels);
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        uint64_t offset = Read<uint64_t>(file, 80 + level * 24);
+        uint64_t length = Read<uint64_t>(file, 88 + level * 24);
+        if (offset > file.size() || length > file.size() - offset)
+        {
+            SDL_Log("Invalid ktx2 level: %u", level);
+            return false;
+        }
+        levels[level] = file.subspan(offset, length);
+    }
+    return DecodeBasisLz(file.subspan(global_offset, global_size), levels, width, height, flip, image);
+}
+
+bool DecodeKtx2(std::span<const uint8_t> file, SDLx_ModelImage& image)
+{
+    static const uint8_t Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    if (file.size() < 80 || std::memcmp(file.data(), Identifier, sizeof(Identifier)))
+    {
+        SDL_Log("Failed to parse ktx2");
+        return false;
+    }
+    uint32_t vk_format = Read<uint32_t>(file, 12);
+    uint32_t width = Read<uint32_t>(file, 20);
+    uint32_t height = Read<uint32_t>(file, 24);
+    uint32_t depth = Read<uint32_t>(file, 28);
+    uint32_t num_layers = Read<uint32_t>(file, 32);
+    uint32_t num_faces = Read<uint32_t>(file, 36);
+    uint32_t num_levels = std::max(Read<uint32_t>(file, 40), 1u);
+    uint32_t supercompression = Read<uint32_t>(file, 44);
+    uint32_t kvd_offset = Read<uint32_t>(file, 56);
+    uint32_t kvd_size = Read<uint32_t>(file, 60);
+    const Format* format = std::find_if(std::begin(Formats), std::end(Formats), [vk_format](const Format& format)
+    {
+        return format.vk_format == vk_format;
+    });
+    /* BasisLZ is ETC1S, the only supercompression without its own format */
+    bool basis_lz = supercompression == 1 && !vk_format;
+    if (!basis_lz && (format == std::end(Formats) || supercompression))
+    {
+        /* zstd payloads, including every UASTC file, would need zstd and a UASTC transcoder */
+        SDL_Log("Unsupported ktx2 format: %u, supercompression: %u", vk_format, supercompression);
+        return false;
+    }
+    /* a full chain ends at 1x1, which also keeps the level shifts below 32 */
+    if (!width || !height || depth > 1 || num_layers > 1 || num_faces != 1 || num_levels > uint32_t(std::bit_width(std::max(width, height))) ||
+        file.size() < 80 + num_levels * 24)
+    {
+        SDL_Log("Unsupported ktx2 layout");
+        return false;
+    }
+    bool flip = !IsBottomUp(file, kvd_offset, kvd_size);
+    if (basis_lz)
+    {
+        return DecodeBasisLzLevels(file, width, height, num_levels, flip, image);
+    }
+    if (flip && !format->flippable)
+    {
+        SDL_Log("Unsupported top-down ktx2 format: %u", vk_format);
+        return false;
+    }
+    size_t size = 0;
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        size += SDL_CalculateGPUTextureFormatSize(format->format, std::max(width >> level, 1u), std::max(height >> level, 1u), 1);
+    }
+    uint8_t* pixels = static_cast<uint8_t*>(SDL_malloc(size));
+    if (!pixels)
+    {
+        SDL_Log("Failed to allocate ktx2 levels");
+        return false;
+    }
+    uint8_t* dst_data = pixels;
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        uint32_t level_width = std::max(width >> level, 1u);
+        uint32_t level_height = std::max(height >> level, 1u);
+        uint32_t level_size = SDL_CalculateGPUTextureFormatSize(format->format, level_width, level_height, 1);
+        uint64_t offset = Read<uint64_t>(file, 80 + level * 24);
+        uint64_t length = Read<uint64_t>(file, 88 + level * 24);
+        if (length != level_size || offset + length > file.size())
+        {
+            SDL_Log("Invalid ktx2 level: %u", level);
+            SDL_free(pixels);
+            return false;
+        }
+        std::memcpy(dst_data, file.data() + offset, level_size);
+        if (flip && !FlipLevel(*format, dst_data, level_width, level_height, level_size))
+        {
+            SDL_Log("Unsupported ktx2 level height: %u", level_height);
+            SDL_free(pixels);
+            return false;
+        }
+        dst_data += level_size;
+    }
+    image.pixels = pixels;
+    image.width = width;
+    image.height = height;
+    image.num_levels = num_levels;
+    image.format = format->format;
+    return true;
+}
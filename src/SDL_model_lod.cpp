@@ -0,0 +1,411 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "internal.hpp"
+
+/*
+ * Quadric error metric simplification by edge collapse. Vertices with the
+ * same position are welded, so a collapse moves one onto a neighbour that
+ * already exists and every level indexes the original vertices. Vertices on
+ * attribute seams are never moved, borders are kept by extra quadrics along
+ * their edges, and collapses that flip a triangle are rejected. Each pass
+ * sorts every edge by cost and collapses greedily, skipping vertices touched
+ * earlier in the pass.
+ */
+
+static constexpr float BorderWeight = 10.0f;
+static constexpr float LodReduction = 0.5f;
+static constexpr float LodMinReduction = 0.85f;
+
+struct Quadric
+{
+    double a00, a01, a02, a03;
+    double a11, a12, a13;
+    double a22, a23;
+    double a33;
+    double weight;
+
+    void AddPlane(double a, double b, double c, double d, double w)
+    {
+        a00 += w * a * a; a01 += w * a * b; a02 += w * a * c; a03 += w * a * d;
+        a11 += w * b * b; a12 += w * b * c; a13 += w * b * d;
+        a22 += w * c * c; a23 += w * c * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& other)
+    {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+        weight += other.weight;
+    }
+
+    /* mean squared distance to the accumulated planes */
+    double Evaluate(const SDLx_ModelVec3& p) const
+    {
+        double x = p.x;
+        double y = p.y;
+        double z = p.z;
+        double error =
+            a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+            a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+            a22 * z * z + 2.0 * a23 * z +
+            a33;
+        return weight > 0.0 ? std::abs(error) / weight : 0.0;
+    }
+};
+
+static void Cross(const SDLx_ModelVec3& a, const SDLx_ModelVec3& b, const SDLx_ModelVec3& c, double normal[3])
+{
+    double e1[3] = {double(b.x) - a.x, double(b.y) - a.y, double(b.z) - a.z};
+    double e2[3] = {double(c.x) - a.x, double(c.y) - a.y, double(c.z) - a.z};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+struct Simplifier
+{
+    const SDLx_ModelVec3* positions;
+    std::vector<uint32_t> remap;           /* original vertex to welded vertex */
+    std::vector<uint32_t> wedges;          /* original vertices per welded vertex */
+    std::vector<SDLx_ModelVec3> welded_positions;
+    std::vector<Quadric> quadrics;
+
+    void Weld(std::span<const uint32_t> indices, uint32_t num_vertices)
+    {
+        struct Key
+        {
+            uint32_t bits[3];
+            bool operator==(const Key& other) const { return !std::memcmp(bits, other.bits, sizeof(bits)); }
+        };
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const { return Hash({reinterpret_cast<const uint8_t*>(key.bits), sizeof(key.bits)}); }
+        };
+        std::unordered_map<Key, uint32_t, KeyHash> position_to_vertex;
+        remap.assign(num_vertices, UINT32_MAX);
+        for (uint32_t index : indices)
+        {
+            if (remap[index] != UINT32_MAX)
+            {
+                continue;
+            }
+            Key key;
+            std::memcpy(key.bits, &positions[index], sizeof(key.bits));
+            auto [it, inserted] = position_to_vertex.try_emplace(key, welded_positions.size());
+            if (inserted)
+            {
+                welded_positions.push_back(positions[index]);
+                wedges.push_back(0);
+            }
+            remap[index] = it->second;
+            wedges[it->second]++;
+        }
+    }
+
+    void ComputeQuadrics(std::span<const uint32_t> indices)
+    {
+        quadrics.assign(welded_positions.size(), Quadric{});
+        std::unordered_map<uint64_t, uint32_t> edge_counts;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            uint32_t v[3] = {remap[indices[i + 0]], remap[indices[i + 1]], remap[indices[i + 2]]};
+            double normal[3];
+            Cross(welded_positions[v[0]], welded_positions[v[1]], welded_positions[v[2]], normal);
+            double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length <= 0.0)
+            {
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                normal[k] /= length;
+            }
+            const SDLx_ModelVec3& p = welded_positions[v[0]];
+            double d = -(normal[0] * p.x + normal[1] * p.y + normal[2] * p.z);
+            for (int k = 0; k < 3; k++)
+            {
+                quadrics[v[k]].AddPlane(normal[0], normal[1], normal[2], d, length * 0.5);
+                uint32_t a = std::min(v[k], v[(k + 1) % 3]);
+                uint32_t b = std::max(v[k], v[(k + 1) % 3]);
+                edge_counts[uint64_t(a) << 32 | b]++;
+            }
+        }
+        /* a plane through each border edge, perpendicular to its triangle */
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            uint32_t v[3] = {remap[indices[i + 0]], remap[indices[i + 1]], remap[indices[i + 2]]};
+            double normal[3];
+            Cross(welded_positions[v[0]], welded_positions[v[1]], welded_positions[v[2]], normal);
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t a = std::min(v[k], v[(k + 1) % 3]);
+                uint32_t b = std::max(v[k], v[(k + 1) % 3]);
+                if (edge_counts[uint64_t(a) << 32 | b] != 1)
+                {
+                    continue;
+                }
+                const SDLx_ModelVec3& p0 = welded_positions[v[k]];
+                const SDLx_ModelVec3& p1 = welded_positions[v[(k + 1) % 3]];
+                double edge[3] = {double(p1.x) - p0.x, double(p1.y) - p0.y, double(p1.z) - p0.z};
+                double plane[3] =
+                {
+                    edge[1] * normal[2] - edge[2] * normal[1],
+                    edge[2] * normal[0] - edge[0] * normal[2],
+                    edge[0] * normal[1] - edge[1] * normal[0],
+                };
+                double length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+                if (length <= 0.0)
+                {
+                    continue;
+                }
+                for (int l = 0; l < 3; l++)
+                {
+                    plane[l] /= length;
+                }
+                double d = -(plane[0] * p0.x + plane[1] * p0.y + plane[2] * p0.z);
+                double weight = BorderWeight * (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+                /* boundary planes constrain without adding area */
+                Quadric quadric{};
+                quadric.AddPlane(plane[0], plane[1], plane[2], d, weight);
+                quadric.weight = 0.0;
+                quadrics[v[k]].Add(quadric);
+                quadrics[v[(k + 1) % 3]].Add(quadric);
+            }
+        }
+    }
+
+    /* true when moving from onto to keeps every other triangle of from facing the same way */
+    bool IsValid(std::span<const uint32_t> indices, const std::vector<uint32_t>& triangles, uint32_t from, uint32_t to) const
+    {
+        for (uint32_t triangle : triangles)
+        {
+            uint32_t v[3] = {remap[indices[triangle * 3 + 0]], remap[indices[triangle * 3 + 1]], remap[indices[triangle * 3 + 2]]};
+            if (v[0] == to || v[1] == to || v[2] == to)
+            {
+                continue;
+            }
+            SDLx_ModelVec3 p[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = welded_positions[v[k]];
+            }
+            double before[3];
+            Cross(p[0], p[1], p[2], before);
+            for (int k = 0; k < 3; k++)
+            {
+                if (v[k] == from)
+                {
+                    p[k] = welded_positions[to];
+                }
+            }
+            double after[3];
+            Cross(p[0], p[1], p[2], after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    float Simplify(std::vector<uint32_t>& indices, size_t target_num_indices)
+    {
+        double max_error = 0.0;
+        std::vector<std::vector<uint32_t>> adjacency(welded_positions.size());
+        std::vector<char> touched(welded_positions.size());
+        struct Collapse
+        {
+            double error;
+            uint32_t from;
+            uint32_t to;
+        };
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> collapse_to(remap.size());
+        while (indices.size() > target_num_indices)
+        {
+            for (std::vector<uint32_t>& triangles : adjacency)
+            {
+                triangles.clear();
+            }
+            collapses.clear();
+            for (uint32_t i = 0; i < indices.size() / 3; i++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    adjacency[remap[indices[i * 3 + k]]].push_back(i);
+                }
+            }
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    /* interior edges are seen twice, the second is skipped as touched */
+                    uint32_t a = remap[indices[i + k]];
+                    uint32_t b = remap[indices[i + (k + 1) % 3]];
+                    Quadric quadric = quadrics[a];
+                    quadric.Add(quadrics[b]);
+                    double error_a = wedges[a] == 1 ? quadric.Evaluate(welded_positions[b]) : HUGE_VAL;
+                    double error_b = wedges[b] == 1 ? quadric.Evaluate(welded_positions[a]) : HUGE_VAL;
+                    if (error_a == HUGE_VAL && error_b == HUGE_VAL)
+                    {
+                        continue;
+                    }
+                    collapses.push_back(error_a <= error_b ? Collapse{error_a, a, b} : Collapse{error_b, b, a});
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                return a.error < b.error;
+            });
+            std::fill(touched.begin(), touched.end(), 0);
+            for (uint32_t i = 0; i < remap.size(); i++)
+            {
+                collapse_to[i] = i;
+            }
+            size_t num_indices = indices.size();
+            size_t num_collapses = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (num_indices <= target_num_indices)
+                {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+                const std::vector<uint32_t>& triangles = adjacency[collapse.from];
+                if (!IsValid(indices, triangles, collapse.from, collapse.to))
+                {
+                    continue;
+                }
+                /* the original vertex of to on the shared edge carries the attributes */
+                uint32_t from_vertex = UINT32_MAX;
+                uint32_t to_vertex = UINT32_MAX;
+                uint32_t num_removed = 0;
+                for (uint32_t triangle : triangles)
+                {
+                    const uint32_t* v = &indices[triangle * 3];
+                    bool has_to = false;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        if (remap[v[k]] == collapse.from)
+                        {
+                            from_vertex = v[k];
+                        }
+                        else if (remap[v[k]] == collapse.to)
+                        {
+                            to_vertex = v[k];
+                            has_to = true;
+                        }
+                    }
+                    /* only the triangles on the collapsed edge degenerate */
+                    if (has_to)
+                    {
+                        num_removed++;
+                    }
+                }
+                if (from_vertex == UINT32_MAX || to_vertex == UINT32_MAX)
+                {
+                    continue;
+                }
+                num_indices -= num_removed * 3;
+                collapse_to[from_vertex] = to_vertex;
+                remap[from_vertex] = collapse.to;
+                quadrics[collapse.to].Add(quadrics[collapse.from]);
+                max_error = std::max(max_error, collapse.error);
+                for (uint32_t triangle : triangles)
+                {
+                    for (int k = 0; k < 3; k++)
+                    {
+                        touched[remap[indices[triangle * 3 + k]]] = 1;
+                    }
+                }
+                touched[collapse.from] = 1;
+                num_collapses++;
+            }
+            if (!num_collapses)
+            {
+                break;
+            }
+            size_t num_kept = 0;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                uint32_t v[3] = {collapse_to[indices[i + 0]], collapse_to[indices[i + 1]], collapse_to[indices[i + 2]]};
+                if (remap[v[0]] == remap[v[1]] || remap[v[1]] == remap[v[2]] || remap[v[0]] == remap[v[2]])
+                {
+                    continue;
+                }
+                indices[num_kept++] = v[0];
+                indices[num_kept++] = v[1];
+                indices[num_kept++] = v[2];
+            }
+            indices.resize(num_kept);
+        }
+        return std::sqrt(max_error);
+    }
+};
+
+bool GenerateLods(SDLx_ModelPrimitiveData& primitive, std::vector<uint32_t>& indices)
+{
+    if (!primitive.positions || !primitive.indices || primitive.num_indices < 3)
+    {
+        return false;
+    }
+    indices.resize(primitive.num_indices / 3 * 3);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            indices[i] = static_cast<const uint16_t*>(primitive.indices)[i];
+        }
+        else
+        {
+            indices[i] = static_cast<const uint32_t*>(primitive.indices)[i];
+        }
+        if (indices[i] >= primitive.num_vertices)
+        {
+            return false;
+        }
+    }
+    size_t num_indices = indices.size();
+    primitive.lods[0] = {0, uint32_t(num_indices), 0.0f};
+    primitive.num_lods = 1;
+    /* every level is simplified from the full mesh so errors don't compound */
+    Simplifier base;
+    base.positions = primitive.positions;
+    base.Weld(std::span(indices.data(), num_indices), primitive.num_vertices);
+    base.ComputeQuadrics(std::span(indices.data(), num_indices));
+    std::vector<uint32_t> lod_indices;
+    for (int i = 1; i < SDLX_MODEL_MAX_LODS; i++)
+    {
+        const SDLx_ModelLod& previous = primitive.lods[i - 1];
+        size_t target_num_indices = size_t(num_indices * std::pow(LodReduction, i)) / 3 * 3;
+        Simplifier simplifier = base;
+        lod_indices.assign(indices.begin(), indices.begin() + num_indices);
+        float error = simplifier.Simplify(lod_indices, target_num_indices);
+        if (lod_indices.empty() || lod_indices.size() > previous.num_indices * LodMinReduction)
+        {
+            break;
+        }
+        SDLx_ModelLod& lod = primitive.lods[primitive.num_lods++];
+        lod.first_index = indices.size();
+        lod.num_indices = lod_indices.size();
+        lod.error = std::max(error, previous.error);
+        indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+    }
+    return true;
+}
@@ -0,0 +1,246 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "internal.hpp"
+
+/*
+ * Meshlets are grown greedily from a seed triangle, always taking the
+ * adjacent triangle that adds the fewest new vertices and, between those,
+ * the one whose vertices have the fewest triangles left, which keeps the
+ * meshlet compact and avoids leaving slivers behind. When nothing adjacent
+ * fits, the meshlet is closed and the next one is seeded from the first
+ * triangle left in index order.
+ */
+
+static constexpr uint8_t NoLocal = 0xFF;
+
+/* below this, the cone would be too wide to ever cull anything */
+static constexpr float MinConeDot = 0.1f;
+
+static void Sub(const SDLx_ModelVec3& a, const SDLx_ModelVec3& b, float out[3])
+{
+    out[0] = a.x - b.x;
+    out[1] = a.y - b.y;
+    out[2] = a.z - b.z;
+}
+
+static float Dot(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void ComputeMeshletBounds(SDLx_ModelMeshlet& meshlet, const SDLx_ModelVec3* positions,
+    const std::vector<uint32_t>& vertices, const std::vector<uint32_t>& triangles)
+{
+    const uint32_t* meshlet_vertices = vertices.data() + meshlet.first_vertex;
+    const uint32_t* meshlet_triangles = triangles.data() + meshlet.first_triangle;
+    SDLx_ModelVec3 min = positions[meshlet_vertices[0]];
+    SDLx_ModelVec3 max = min;
+    for (uint32_t i = 1; i < meshlet.num_vertices; i++)
+    {
+        const SDLx_ModelVec3& position = positions[meshlet_vertices[i]];
+        min = {std::min(min.x, position.x), std::min(min.y, position.y), std::min(min.z, position.z)};
+        max = {std::max(max.x, position.x), std::max(max.y, position.y), std::max(max.z, position.z)};
+    }
+    SDLx_ModelVec3 center = {(min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f};
+    float radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.num_vertices; i++)
+    {
+        float offset[3];
+        Sub(positions[meshlet_vertices[i]], center, offset);
+        radius = std::max(radius, Dot(offset, offset));
+    }
+    meshlet.center = center;
+    meshlet.radius = std::sqrt(radius);
+    meshlet.cone_apex = center;
+    meshlet.cone_axis = {};
+    meshlet.cone_cutoff = 1.0f;
+    /* the axis is the mean of the unit normals, the cutoff from the widest of them */
+    std::vector<float> normals(meshlet.num_triangles * 3);
+    float axis[3] = {};
+    for (uint32_t i = 0; i < meshlet.num_triangles; i++)
+    {
+        uint32_t packed = meshlet_triangles[i];
+        const SDLx_ModelVec3& a = positions[meshlet_vertices[packed & 0xFF]];
+        const SDLx_ModelVec3& b = positions[meshlet_vertices[(packed >> 8) & 0xFF]];
+        const SDLx_ModelVec3& c = positions[meshlet_vertices[(packed >> 16) & 0xFF]];
+        float e1[3];
+        float e2[3];
+        Sub(b, a, e1);
+        Sub(c, a, e2);
+        float* normal = &normals[i * 3];
+        normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        float length = std::sqrt(Dot(normal, normal));
+        if (length <= 0.0f)
+        {
+            continue;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            normal[k] /= length;
+            axis[k] += normal[k];
+        }
+    }
+    float length = std::sqrt(Dot(axis, axis));
+    if (length <= 0.0f)
+    {
+        return;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        axis[k] /= length;
+    }
+    float min_dot = 1.0f;
+    for (uint32_t i = 0; i < meshlet.num_triangles; i++)
+    {
+        const float* normal = &normals[i * 3];
+        if (normal[0] || normal[1] || normal[2])
+        {
+            min_dot = std::min(min_dot, Dot(axis, normal));
+        }
+    }
+    if (min_dot <= MinConeDot)
+    {
+        return;
+    }
+    /* move the apex back along the axis until it's behind every triangle */
+    float max_t = 0.0f;
+    for (uint32_t i = 0; i < meshlet.num_triangles; i++)
+    {
+        const float* normal = &normals[i * 3];
+        if (!normal[0] && !normal[1] && !normal[2])
+        {
+            continue;
+        }
+        float offset[3];
+        Sub(center, positions[meshlet_vertices[meshlet_triangles[i] & 0xFF]], offset);
+        max_t = std::max(max_t, Dot(offset, normal) / Dot(axis, normal));
+    }
+    meshlet.cone_apex = {center.x - axis[0] * max_t, center.y - axis[1] * max_t, center.z - axis[2] * max_t};
+    meshlet.cone_axis = {axis[0], axis[1], axis[2]};
+    meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+}
+
+void BuildMeshlets(const SDLx_ModelPrimitiveData& primitive, std::vector<SDLx_ModelMeshlet>& meshlets,
+    std::vector<uint32_t>& vertices, std::vector<uint32_t>& triangles)
+{
+    if (!primitive.positions || !primitive.indices)
+    {
+        return;
+    }
+    /* only the full resolution level, the lods are drawn with the index buffer */
+    uint32_t num_indices = (primitive.num_lods ? primitive.lods[0].num_indices : primitive.num_indices) / 3 * 3;
+    std::vector<uint32_t> indices(num_indices);
+    for (uint32_t i = 0; i < num_indices; i++)
+    {
+        if (primitive.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            indices[i] = static_cast<const uint16_t*>(primitive.indices)[i];
+        }
+        else
+        {
+            indices[i] = static_cast<const uint32_t*>(primitive.indices)[i];
+        }
+        if (indices[i] >= primitive.num_vertices)
+        {
+            return;
+        }
+    }
+    uint32_t num_triangles = num_indices / 3;
+    std::vector<uint32_t> offsets(primitive.num_vertices + 1);
+    for (uint32_t index : indices)
+    {
+        offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> adjacency(num_indices);
+    std::vector<uint32_t> live(primitive.num_vertices);
+    for (uint32_t i = 0; i < num_indices; i++)
+    {
+        adjacency[offsets[indices[i]] + live[indices[i]]++] = i / 3;
+    }
+    std::vector<uint8_t> local(primitive.num_vertices, NoLocal);
+    std::vector<char> emitted(num_triangles);
+    uint32_t seed = 0;
+    while (true)
+    {
+        while (seed < num_triangles && emitted[seed])
+        {
+            seed++;
+        }
+        if (seed == num_triangles)
+        {
+            break;
+        }
+        SDLx_ModelMeshlet& meshlet = meshlets.emplace_back();
+        meshlet.first_vertex = vertices.size();
+        meshlet.first_triangle = triangles.size();
+        uint32_t triangle = seed;
+        while (triangle != UINT32_MAX)
+        {
+            const uint32_t* v = &indices[triangle * 3];
+            uint32_t packed = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                if (local[v[k]] == NoLocal)
+                {
+                    local[v[k]] = meshlet.num_vertices++;
+                    vertices.push_back(v[k]);
+                }
+                packed |= uint32_t(local[v[k]]) << (k * 8);
+                live[v[k]]--;
+            }
+            triangles.push_back(packed);
+            emitted[triangle] = 1;
+            triangle = UINT32_MAX;
+            if (++meshlet.num_triangles == SDLX_MODEL_MAX_MESHLET_TRIANGLES)
+            {
+                break;
+            }
+            int best_new = 4;
+            uint32_t best_live = UINT32_MAX;
+            for (uint32_t i = meshlet.first_vertex; i < vertices.size(); i++)
+            {
+                uint32_t vertex = vertices[i];
+                if (!live[vertex])
+                {
+                    continue;
+                }
+                for (uint32_t j = offsets[vertex]; j < offsets[vertex + 1]; j++)
+                {
+                    uint32_t candidate = adjacency[j];
+                    if (emitted[candidate])
+                    {
+                        continue;
+                    }
+                    const uint32_t* c = &indices[candidate * 3];
+                    int num_new = (local[c[0]] == NoLocal) + (local[c[1]] == NoLocal) + (local[c[2]] == NoLocal);
+                    uint32_t num_live = live[c[0]] + live[c[1]] + live[c[2]];
+                    if (meshlet.num_vertices + num_new > SDLX_MODEL_MAX_MESHLET_VERTICES)
+                    {
+                        continue;
+                    }
+                    if (num_new < best_new || (num_new == best_new && num_live < best_live))
+                    {
+                        triangle = candidate;
+                        best_new = num_new;
+                        best_live = num_live;
+                    }
+                }
+            }
+        }
+        for (uint32_t i = meshlet.first_vertex; i < vertices.size(); i++)
+        {
+            local[vertices[i]] = NoLocal;
+        }
+        ComputeMeshletBounds(meshlet, primitive.positions, vertices, triangles);
+    }
+}
@@ -0,0 +1,344 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "internal.hpp"
+
+/*
+ * Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+ * Locality and Reduced Overdraw") orders triangles by fanning around a
+ * vertex and picking the next fanning vertex among the ones just emitted
+ * that will still be in the cache. The result is then split into clusters
+ * at cache flushes and wherever the running miss rate is already close to
+ * that of the whole patch, and the clusters are drawn outermost first so
+ * the silhouette occludes the rest. Caches are simulated as FIFOs with
+ * timestamps: a vertex is cached while fewer than CacheSize misses have
+ * happened since it was last loaded.
+ */
+
+static constexpr uint32_t CacheSize = 16;
+static constexpr float ClusterThreshold = 1.05f;
+
+struct Adjacency
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+    std::vector<uint32_t> live;
+
+    Adjacency(std::span<const uint32_t> indices, uint32_t num_vertices)
+        : offsets(num_vertices + 1)
+        , triangles(indices.size())
+        , live(num_vertices)
+    {
+        for (uint32_t index : indices)
+        {
+            offsets[index + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            triangles[offsets[indices[i]] + live[indices[i]]++] = i / 3;
+        }
+    }
+};
+
+static uint32_t UpdateCache(const uint32_t* triangle, std::vector<uint32_t>& timestamps, uint32_t& timestamp)
+{
+    uint32_t misses = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        if (timestamp - timestamps[triangle[k]] > CacheSize)
+        {
+            timestamps[triangle[k]] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+static void Tipsify(std::span<uint32_t> indices, uint32_t num_vertices)
+{
+    uint32_t num_triangles = indices.size() / 3;
+    Adjacency adjacency(indices, num_vertices);
+    std::vector<uint32_t> timestamps(num_vertices);
+    std::vector<char> emitted(num_triangles);
+    std::vector<uint32_t> dead_ends;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    uint32_t timestamp = CacheSize + 1;
+    uint32_t cursor = 0;
+    uint32_t fanning = 0;
+    while (fanning != UINT32_MAX)
+    {
+        candidates.clear();
+        for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++)
+        {
+            uint32_t triangle = adjacency.triangles[i];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = 1;
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t vertex = indices[triangle * 3 + k];
+                result.push_back(vertex);
+                dead_ends.push_back(vertex);
+                candidates.push_back(vertex);
+                adjacency.live[vertex]--;
+                if (timestamp - timestamps[vertex] > CacheSize)
+                {
+                    timestamps[vertex] = timestamp++;
+                }
+            }
+        }
+        /* the candidate that stays cached longest while all of its triangles are emitted */
+        fanning = UINT32_MAX;
+        int64_t best_priority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (!adjacency.live[vertex])
+            {
+                continue;
+            }
+            int64_t priority = 0;
+            if (timestamp - timestamps[vertex] + 2 * adjacency.live[vertex] <= CacheSize)
+            {
+                priority = timestamp - timestamps[vertex];
+            }
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                fanning = vertex;
+            }
+        }
+        if (fanning != UINT32_MAX)
+        {
+            continue;
+        }
+        while (!dead_ends.empty() && fanning == UINT32_MAX)
+        {
+            uint32_t vertex = dead_ends.back();
+            dead_ends.pop_back();
+            if (adjacency.live[vertex])
+            {
+                fanning = vertex;
+            }
+        }
+        for (; fanning == UINT32_MAX && cursor < num_vertices; cursor++)
+        {
+            if (adjacency.live[cursor])
+            {
+                fanning = cursor;
+            }
+        }
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+/* the first triangle of every cluster */
+static std::vector<uint32_t> GetClusters(std::span<const uint32_t> indices, uint32_t num_vertices)
+{
+    uint32_t num_triangles = indices.size() / 3;
+    std::vector<uint32_t> timestamps(num_vertices);
+    uint32_t timestamp = CacheSize + 1;
+    /* three misses at once usually means a disjoint patch */
+    std::vector<uint32_t> patches;
+    for (uint32_t i = 0; i < num_triangles; i++)
+    {
+        if (UpdateCache(&indices[i * 3], timestamps, timestamp) == 3 || !i)
+        {
+            patches.push_back(i);
+        }
+    }
+    std::vector<uint32_t> clusters;
+    for (size_t i = 0; i < patches.size(); i++)
+    {
+        uint32_t start = patches[i];
+        uint32_t end = i + 1 < patches.size() ? patches[i + 1] : num_triangles;
+        timestamp += CacheSize + 1;
+        uint32_t patch_misses = 0;
+        for (uint32_t j = start; j < end; j++)
+        {
+            patch_misses += UpdateCache(&indices[j * 3], timestamps, timestamp);
+        }
+        float threshold = ClusterThreshold * patch_misses / (end - start);
+        size_t first_cluster = clusters.size();
+        clusters.push_back(start);
+        timestamp += CacheSize + 1;
+        uint32_t misses = 0;
+        uint32_t count = 0;
+        for (uint32_t j = start; j < end; j++)
+        {
+            misses += UpdateCache(&indices[j * 3], timestamps, timestamp);
+            count++;
+            if (float(misses) / count <= threshold)
+            {
+                clusters.push_back(j + 1);
+                timestamp += CacheSize + 1;
+                misses = 0;
+                count = 0;
+            }
+        }
+        /* the leftover triangles would make a poor cluster of their own, merge them into the last one */
+        if (clusters.size() > first_cluster + 1)
+        {
+            clusters.pop_back();
+        }
+    }
+    return clusters;
+}
+
+static void SortClusters(std::span<uint32_t> indices, const SDLx_ModelVec3* positions, const std::vector<uint32_t>& clusters)
+{
+    uint32_t num_triangles = indices.size() / 3;
+    struct Cluster
+    {
+        uint32_t start;
+        uint32_t end;
+        double centroid[3];
+        double normal[3];
+        double area;
+        double sort;
+    };
+    std::vector<Cluster> sorted(clusters.size());
+    double centroid[3] = {};
+    double area = 0.0;
+    for (size_t i = 0; i < clusters.size(); i++)
+    {
+        Cluster& cluster = sorted[i];
+        cluster = {};
+        cluster.start = clusters[i];
+        cluster.end = i + 1 < clusters.size() ? clusters[i + 1] : num_triangles;
+        for (uint32_t j = cluster.start; j < cluster.end; j++)
+        {
+            const SDLx_ModelVec3& a = positions[indices[j * 3 + 0]];
+            const SDLx_ModelVec3& b = positions[indices[j * 3 + 1]];
+            const SDLx_ModelVec3& c = positions[indices[j * 3 + 2]];
+            double e1[3] = {double(b.x) - a.x, double(b.y) - a.y, double(b.z) - a.z};
+            double e2[3] = {double(c.x) - a.x, double(c.y) - a.y, double(c.z) - a.z};
+            double normal[3] =
+            {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0],
+            };
+            double triangle_area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            double center[3] = {(double(a.x) + b.x + c.x) / 3.0, (double(a.y) + b.y + c.y) / 3.0, (double(a.z) + b.z + c.z) / 3.0};
+            for (int k = 0; k < 3; k++)
+            {
+                cluster.centroid[k] += center[k] * triangle_area;
+                cluster.normal[k] += normal[k];
+            }
+            cluster.area += triangle_area;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            centroid[k] += cluster.centroid[k];
+            cluster.centroid[k] /= cluster.area > 0.0 ? cluster.area : 1.0;
+        }
+        area += cluster.area;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        centroid[k] /= area > 0.0 ? area : 1.0;
+    }
+    /* clusters facing away from the center are more likely to be in front */
+    for (Cluster& cluster : sorted)
+    {
+        double length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+        cluster.sort = 0.0;
+        for (int k = 0; k < 3; k++)
+        {
+            cluster.sort += (cluster.centroid[k] - centroid[k]) * (length > 0.0 ? cluster.normal[k] / length : 0.0);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& lhs, const Cluster& rhs)
+    {
+        return lhs.sort > rhs.sort;
+    });
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster : sorted)
+    {
+        result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void OptimizeIndices(std::span<uint32_t> indices, const SDLx_ModelVec3* positions, uint32_t num_vertices)
+{
+    if (indices.size() < 6)
+    {
+        return;
+    }
+    Tipsify(indices, num_vertices);
+    if (positions)
+    {
+        SortClusters(indices, positions, GetClusters(indices, num_vertices));
+    }
+}
+
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t num_vertices)
+{
+    std::vector<uint32_t> remap(num_vertices, UINT32_MAX);
+    std::vector<uint32_t> order;
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = order.size();
+            order.push_back(index);
+        }
+        index = remap[index];
+    }
+    return order;
+}
+
+void VertexCacheStats::Analyze(std::span<const uint32_t> indices, uint32_t num_vertices)
+{
+    std::vector<uint32_t> timestamps(num_vertices);
+    std::vector<char> used(num_vertices);
+    uint32_t timestamp = CacheSize + 1;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        num_transforms += UpdateCache(&indices[i], timestamps, timestamp);
+        num_triangles++;
+    }
+    for (uint32_t index : indices)
+    {
+        if (!used[index])
+        {
+            used[index] = 1;
+            this->num_vertices++;
+        }
+    }
+}
+
+SDLx_ModelIndexStats VertexCacheStats::Get() const
+{
+    SDLx_ModelIndexStats stats{};
+    if (num_triangles)
+    {
+        stats.acmr = float(double(num_transforms) / num_triangles);
+    }
+    if (num_vertices)
+    {
+        stats.atvr = float(double(num_transforms) / num_vertices);
+    }
+    return stats;
+}
+
+void VertexCacheStats::Add(const VertexCacheStats& other)
+{
+    num_triangles += other.num_triangles;
+    num_vertices += other.num_vertices;
+    num_transforms += other.num_transforms;
+}
@@ -0,0 +1,119 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "internal.hpp"
+
+/*
+ * Resources shared between models of one device, reference counted by every
+ * model (or decoded data) holding them. The last release destroys the
+ * resource and forgets its key.
+ */
+
+struct Entry
+{
+    std::string key;
+    int references;
+    bool texture;
+};
+
+struct Registry
+{
+    std::unordered_map<std::string, void*> resources;
+    std::unordered_map<void*, Entry> entries;
+};
+
+static std::mutex mutex;
+static std::unordered_map<SDL_GPUDevice*, Registry> registries;
+
+static void* Acquire(SDL_GPUDevice* device, const std::string& key)
+{
+    std::lock_guard lock(mutex);
+    auto registry = registries.find(device);
+    if (registry == registries.end())
+    {
+        return nullptr;
+    }
+    auto resource = registry->second.resources.find(key);
+    if (resource == registry->second.resources.end())
+    {
+        return nullptr;
+    }
+    registry->second.entries[resource->second].references++;
+    return resource->second;
+}
+
+static bool Share(SDL_GPUDevice* device, const std::string& key, void* resource, bool texture)
+{
+    std::lock_guard lock(mutex);
+    Registry& registry = registries[device];
+    if (!registry.resources.try_emplace(key, resource).second)
+    {
+        /* another load shared the same key first */
+        return false;
+    }
+    registry.entries[resource] = {key, 1, texture};
+    return true;
+}
+
+static void Release(SDL_GPUDevice* device, void* resource)
+{
+    std::lock_guard lock(mutex);
+    auto registry = registries.find(device);
+    if (registry == registries.end())
+    {
+        return;
+    }
+    auto entry = registry->second.entries.find(resource);
+    if (entry == registry->second.entries.end() || --entry->second.references > 0)
+    {
+        return;
+    }
+    if (entry->second.texture)
+    {
+        SDL_ReleaseGPUTexture(device, static_cast<SDL_GPUTexture*>(resource));
+    }
+    else
+    {
+        SDL_ReleaseGPUBuffer(device, static_cast<SDL_GPUBuffer*>(resource));
+    }
+    registry->second.resources.erase(entry->second.key);
+    registry->second.entries.erase(entry);
+    if (registry->second.entries.empty())
+    {
+        registries.erase(registry);
+    }
+}
+
+SDL_GPUTexture* AcquireSharedTexture(SDL_GPUDevice* device, const std::string& key)
+{
+    return static_cast<SDL_GPUTexture*>(Acquire(device, key));
+}
+
+bool ShareTexture(SDL_GPUDevice* device, const std::string& key, SDL_GPUTexture* texture)
+{
+    return Share(device, key, texture, true);
+}
+
+void ReleaseSharedTexture(SDL_GPUDevice* device, SDL_GPUTexture* texture)
+{
+    Release(device, texture);
+}
+
+SDL_GPUBuffer* AcquireSharedBuffer(SDL_GPUDevice* device, const std::string& key)
+{
+    return static_cast<SDL_GPUBuffer*>(Acquire(device, key));
+}
+
+bool ShareBuffer(SDL_GPUDevice* device, const std::string& key, SDL_GPUBuffer* buffer)
+{
+    return Share(device, key, buffer, false);
+}
+
+void ReleaseSharedBuffer(SDL_GPUDevice* device, SDL_GPUBuffer* buffer)
+{
+    Release(device, buffer);
+}
@@ -0,0 +1,1574 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "internal.hpp"
+
+/*
+ * Block decompression into RGBA8 and a small block compressor, for textures
+ * the device can't sample as they are. BC1-5, BC7 and LDR ASTC 4x4 decode
+ * completely. Compression fits one line through the texels of each block and
+ * writes BC3, BC7 modes 5 and 6 or single partition ASTC 4x4, trading some
+ * quality for speed.
+ */
+
+static uint32_t ReadBits(const uint8_t* block, uint32_t offset, uint32_t count, uint32_t end = 128)
+{
+    /* little endian bits, zero past end */
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < count && offset + i < end; i++)
+    {
+        value |= uint32_t((block[(offset + i) / 8] >> ((offset + i) % 8)) & 1) << i;
+    }
+    return value;
+}
+
+static void WriteBits(uint8_t* block, uint32_t& offset, uint32_t value, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++, offset++)
+    {
+        block[offset / 8] |= ((value >> i) & 1) << (offset % 8);
+    }
+}
+
+static uint8_t Interpolate(int value1, int value2, int weight)
+{
+    return ((64 - weight) * value1 + weight * value2 + 32) >> 6;
+}
+
+static constexpr uint8_t Weights2[4] = {0, 21, 43, 64};
+static constexpr uint8_t Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static constexpr uint8_t Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static const uint8_t* GetWeights(int bits)
+{
+    return bits == 2 ? Weights2 : bits == 3 ? Weights3 : Weights4;
+}
+
+static void DecompressColor(const uint8_t* block, uint8_t* texels, bool opaque)
+{
+    uint16_t endpoints[2];
+    std::memcpy(endpoints, block, 4);
+    uint8_t colors[4][4];
+    for (int i = 0; i < 2; i++)
+    {
+        colors[i][0] = ((endpoints[i] >> 11) & 0x1F) * 255 / 31;
+        colors[i][1] = ((endpoints[i] >> 5) & 0x3F) * 255 / 63;
+        colors[i][2] = ((endpoints[i] >> 0) & 0x1F) * 255 / 31;
+        colors[i][3] = 255;
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        if (opaque || endpoints[0] > endpoints[1])
+        {
+            colors[2][c] = (2 * colors[0][c] + colors[1][c] + 1) / 3;
+            colors[3][c] = (colors[0][c] + 2 * colors[1][c] + 1) / 3;
+        }
+        else
+        {
+            colors[2][c] = (colors[0][c] + colors[1][c] + 1) / 2;
+            colors[3][c] = 0;
+        }
+    }
+    uint32_t indices;
+    std::memcpy(&indices, block + 4, 4);
+    for (int i = 0; i < 16; i++)
+    {
+        std::memcpy(texels + i * 4, colors[(indices >> (i * 2)) & 0x3], 4);
+    }
+}
+
+static void GetAlphas(const uint8_t* block, uint8_t alphas[8])
+{
+    alphas[0] = block[0];
+    alphas[1] = block[1];
+    for (int i = 2; i < 8; i++)
+    {
+        if (block[0] > block[1])
+        {
+            alphas[i] = ((8 - i) * block[0] + (i - 1) * block[1]) / 7;
+        }
+        else if (i < 6)
+        {
+            alphas[i] = ((6 - i) * block[0] + (i - 1) * block[1]) / 5;
+        }
+        else
+        {
+            alphas[i] = i == 6 ? 0 : 255;
+        }
+    }
+}
+
+static void DecompressAlpha(const uint8_t* block, uint8_t* texels, int channel)
+{
+    uint8_t alphas[8];
+    GetAlphas(block, alphas);
+    uint64_t indices = 0;
+    std::memcpy(&indices, block + 2, 6);
+    for (int i = 0; i < 16; i++)
+    {
+        texels[i * 4 + channel] = alphas[(indices >> (i * 3)) & 0x7];
+    }
+}
+
+struct Bc7Mode
+{
+    int num_subsets;
+    int partition_bits;
+    int rotation_bits;
+    int selector_bits;
+    int color_bits;
+    int alpha_bits;
+    int endpoint_pbits;
+    int shared_pbits;
+    int index_bits;
+    int index_bits2;
+};
+
+static constexpr Bc7Mode Bc7Modes[8] =
+{
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+    {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+    {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+    {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+/* bit i is the subset of texel i */
+static constexpr uint16_t Bc7Partitions2[64] =
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+/* bits 2i and 2i + 1 are the subset of texel i */
+static constexpr uint32_t Bc7Partitions3[64] =
+{
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+};
+
+static constexpr uint8_t Bc7Anchors2[64] =
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+static constexpr uint8_t Bc7Anchors3[2][64] =
+{
+    {
+         3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+         3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+         8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+         3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+    },
+    {
+        15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+        15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+        15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+        15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+    },
+};
+
+static int GetBc7Subset(const Bc7Mode& mode, int partition, int texel)
+{
+    switch (mode.num_subsets)
+    {
+    case 2:
+        return (Bc7Partitions2[partition] >> texel) & 1;
+    case 3:
+        return (Bc7Partitions3[partition] >> (texel * 2)) & 3;
+    }
+    return 0;
+}
+
+static bool IsBc7Anchor(const Bc7Mode& mode, int partition, int texel)
+{
+    switch (mode.num_subsets)
+    {
+    case 2:
+        return !texel || texel == Bc7Anchors2[partition];
+    case 3:
+        return !texel || texel == Bc7Anchors3[0][partition] || texel == Bc7Anchors3[1][partition];
+    }
+    return !texel;
+}
+
+static void DecompressBc7(const uint8_t* block, uint8_t* texels)
+{
+    if (!block[0])
+    {
+        /* the reserved mode decodes to transparent black */
+        std::memset(texels, 0, 64);
+        return;
+    }
+    int mode_index = std::countr_zero(block[0]);
+    const Bc7Mode& mode = Bc7Modes[mode_index];
+    uint32_t offset = mode_index + 1;
+    auto Read = [block, &offset](int count)
+    {
+        uint32_t value = ReadBits(block, offset, count);
+        offset += count;
+        return int(value);
+    };
+    int partition = Read(mode.partition_bits);
+    int rotation = Read(mode.rotation_bits);
+    int selector = Read(mode.selector_bits);
+    int endpoints[3][2][4];
+    for (int c = 0; c < 4; c++)
+    {
+        for (int s = 0; s < mode.num_subsets; s++)
+        {
+            for (int e = 0; e < 2; e++)
+            {
+                int bits = c < 3 ? mode.color_bits : mode.alpha_bits;
+                endpoints[s][e][c] = bits ? Read(bits) : 255;
+            }
+        }
+    }
+    int pbits[3][2] = {};
+    for (int s = 0; s < mode.num_subsets; s++)
+    {
+        for (int e = 0; e < 2 && mode.endpoint_pbits; e++)
+        {
+            pbits[s][e] = Read(1);
+        }
+        if (mode.shared_pbits)
+        {
+            pbits[s][0] = pbits[s][1] = Read(1);
+        }
+    }
+    for (int s = 0; s < mode.num_subsets; s++)
+    {
+        for (int e = 0; e < 2; e++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                int bits = c < 3 ? mode.color_bits : mode.alpha_bits;
+                if (!bits)
+                {
+                    continue;
+                }
+                int value = endpoints[s][e][c];
+                if (mode.endpoint_pbits || mode.shared_pbits)
+                {
+                    value = (value << 1) | pbits[s][e];
+                    bits++;
+                }
+                endpoints[s][e][c] = (value << (8 - bits)) | (value >> (2 * bits - 8));
+            }
+        }
+    }
+    int indices[16];
+    int indices2[16] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        indices[i] = Read(mode.index_bits - IsBc7Anchor(mode, partition, i));
+    }
+    for (int i = 0; i < 16 && mode.index_bits2; i++)
+    {
+        indices2[i] = Read(mode.index_bits2 - !i);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        const int (*subset)[4] = endpoints[GetBc7Subset(mode, partition, i)];
+        int color_index = indices[i];
+        int color_bits = mode.index_bits;
+        int alpha_index = mode.index_bits2 ? indices2[i] : indices[i];
+        int alpha_bits = mode.index_bits2 ? mode.index_bits2 : mode.index_bits;
+        if (selector)
+        {
+            std::swap(color_index, alpha_index);
+            std::swap(color_bits, alpha_bits);
+        }
+        uint8_t* texel = texels + i * 4;
+        for (int c = 0; c < 3; c++)
+        {
+            texel[c] = Interpolate(subset[0][c], subset[1][c], GetWeights(color_bits)[color_index]);
+        }
+        texel[3] = Interpolate(subset[0][3], subset[1][3], GetWeights(alpha_bits)[alpha_index]);
+        if (rotation)
+        {
+            std::swap(texel[3], texel[rotation - 1]);
+        }
+    }
+}
+
+/*
+ * ASTC integer sequence encoding. Values pack trits five at a time into eight
+ * bits, or quints three at a time into seven bits, interleaved with the low
+ * bits of each value.
+ */
+
+struct IseRange
+{
+    int levels;
+    int trits;
+    int quints;
+    int bits;
+};
+
+static constexpr IseRange IseRanges[21] =
+{
+    {2, 0, 0, 1}, {3, 1, 0, 0}, {4, 0, 0, 2}, {5, 0, 1, 0}, {6, 1, 0, 1}, {8, 0, 0, 3}, {10, 0, 1, 1},
+    {12, 1, 0, 2}, {16, 0, 0, 4}, {20, 0, 1, 2}, {24, 1, 0, 3}, {32, 0, 0, 5}, {40, 0, 1, 3}, {48, 1, 0, 4},
+    {64, 0, 0, 6}, {80, 0, 1, 4}, {96, 1, 0, 5}, {128, 0, 0, 7}, {160, 0, 1, 5}, {192, 1, 0, 6}, {256, 0, 0, 8},
+};
+
+static constexpr uint8_t AstcErrorColor[4] = {255, 0, 255, 255};
+
+static int GetIseSize(const IseRange& range, int count)
+{
+    int size = count * range.bits;
+    if (range.trits)
+    {
+        size += (count * 8 + 4) / 5;
+    }
+    if (range.quints)
+    {
+        size += (count * 7 + 2) / 3;
+    }
+    return size;
+}
+
+static void DecodeTrits(uint32_t packed, uint8_t trits[5])
+{
+    auto Bit = [](uint32_t value, int i) { return (value >> i) & 1; };
+    uint32_t c;
+    if (((packed >> 2) & 7) == 7)
+    {
+        c = (((packed >> 5) & 7) << 2) | (packed & 3);
+        trits[4] = 2;
+        trits[3] = 2;
+    }
+    else
+    {
+        c = packed & 0x1F;
+        if (((packed >> 5) & 3) == 3)
+        {
+            trits[4] = 2;
+            trits[3] = Bit(packed, 7);
+        }
+        else
+        {
+            trits[4] = Bit(packed, 7);
+            trits[3] = (packed >> 5) & 3;
+        }
+    }
+    if ((c & 3) == 3)
+    {
+        trits[2] = 2;
+        trits[1] = Bit(c, 4);
+        trits[0] = (Bit(c, 3) << 1) | (Bit(c, 2) & !Bit(c, 3));
+    }
+    else if (((c >> 2) & 3) == 3)
+    {
+        trits[2] = 2;
+        trits[1] = 2;
+        trits[0] = c & 3;
+    }
+    else
+    {
+        trits[2] = Bit(c, 4);
+        trits[1] = (c >> 2) & 3;
+        trits[0] = (Bit(c, 1) << 1) | (Bit(c, 0) & !Bit(c, 1));
+    }
+}
+
+static void DecodeQuints(uint32_t packed, uint8_t quints[3])
+{
+    auto Bit = [](uint32_t value, int i) { return (value >> i) & 1; };
+    if (((packed >> 1) & 3) == 3 && !((packed >> 5) & 3))
+    {
+        quints[2] = (Bit(packed, 0) << 2) | ((Bit(packed, 4) & !Bit(packed, 0)) << 1) | (Bit(packed, 3) & !Bit(packed, 0));
+        quints[1] = 4;
+        quints[0] = 4;
+        return;
+    }
+    uint32_t c;
+    if (((packed >> 1) & 3) == 3)
+    {
+        quints[2] = 4;
+        c = (((packed >> 3) & 3) << 3) | ((~(packed >> 5) & 3) << 1) | Bit(packed, 0);
+    }
+    else
+    {
+        quints[2] = (packed >> 5) & 3;
+        c = packed & 0x1F;
+    }
+    if ((c & 7) == 5)
+    {
+        quints[1] = 4;
+        quints[0] = (c >> 3) & 3;
+    }
+    else
+    {
+        quints[1] = (c >> 3) & 3;
+        quints[0] = c & 7;
+    }
+}
+
+static void DecodeIse(const uint8_t* block, uint32_t offset, const IseRange& range, int count, uint8_t* bits, uint8_t* digits)
+{
+    uint32_t end = offset + GetIseSize(range, count);
+    auto Read = [block, &offset, end](int count)
+    {
+        uint32_t value = ReadBits(block, offset, count, end);
+        offset += count;
+        return value;
+    };
+    static constexpr int TritBits[5] = {2, 2, 1, 2, 1};
+    static constexpr int QuintBits[3] = {3, 2, 2};
+    int group = range.trits ? 5 : range.quints ? 3 : 1;
+    const int* packed_bits = range.trits ? TritBits : QuintBits;
+    for (int i = 0; i < count; i += group)
+    {
+        uint8_t values[5] = {};
+        uint8_t group_digits[5] = {};
+        uint32_t packed = 0;
+        int shift = 0;
+        for (int j = 0; j < group; j++)
+        {
+            values[j] = Read(range.bits);
+            if (group > 1)
+            {
+                packed |= Read(packed_bits[j]) << shift;
+                shift += packed_bits[j];
+            }
+        }
+        if (range.trits)
+        {
+            DecodeTrits(packed, group_digits);
+        }
+        else if (range.quints)
+        {
+            DecodeQuints(packed, group_digits);
+        }
+        for (int j = 0; j < group && i + j < count; j++)
+        {
+            bits[i + j] = values[j];
+            digits[i + j] = group_digits[j];
+        }
+    }
+}
+
+static int Replicate(int value, int bits, int dst_bits)
+{
+    int result = 0;
+    for (int shift = dst_bits - bits; shift > -bits; shift -= bits)
+    {
+        result |= shift >= 0 ? value << shift : value >> -shift;
+    }
+    return result;
+}
+
+static uint8_t UnquantizeColor(const IseRange& range, int value, int digit)
+{
+    if (!range.trits && !range.quints)
+    {
+        return Replicate(value, range.bits, 8);
+    }
+    int a = value & 1;
+    int b = (value >> 1) & 1;
+    int c = (value >> 2) & 1;
+    int d = (value >> 3) & 1;
+    int e = (value >> 4) & 1;
+    int f = (value >> 5) & 1;
+    int scale = 0;
+    int offset = 0;
+    if (range.trits)
+    {
+        static constexpr int Scales[7] = {0, 204, 93, 44, 22, 11, 5};
+        scale = Scales[range.bits];
+        switch (range.bits)
+        {
+        case 2: offset = b * 0x116; break;
+        case 3: offset = (c << 8) | (b << 7) | (c << 3) | (b << 2) | (c << 1) | b; break;
+        case 4: offset = (d << 8) | (c << 7) | (b << 6) | (d << 2) | (c << 1) | b; break;
+        case 5: offset = (e << 8) | (d << 7) | (c << 6) | (b << 5) | e; break;
+        case 6: offset = (f << 8) | (e << 7) | (d << 6) | (c << 5) | (b << 4); break;
+        }
+    }
+    else
+    {
+        static constexpr int Scales[6] = {0, 113, 54, 26, 13, 6};
+        scale = Scales[range.bits];
+        switch (range.bits)
+        {
+        case 2: offset = (b << 8) | (b << 3) | (b << 2); break;
+        case 3: offset = (c << 8) | (b << 7) | (c << 2) | (b << 1) | c; break;
+        case 4: offset = (d << 8) | (c << 7) | (b << 6) | (d << 1) | c; break;
+        case 5: offset = (e << 8) | (d << 7) | (c << 6) | (b << 5); break;
+        }
+    }
+    int mask = a ? 0x1FF : 0;
+    int result = (digit * scale + offset) ^ mask;
+    return (mask & 0x80) | (result >> 2);
+}
+
+static uint8_t UnquantizeWeight(const IseRange& range, int value, int digit)
+{
+    int result;
+    if (!range.trits && !range.quints)
+    {
+        result = Replicate(value, range.bits, 6);
+    }
+    else if (!range.bits)
+    {
+        return digit * (range.trits ? 32 : 16);
+    }
+    else
+    {
+        int a = value & 1;
+        int b = (value >> 1) & 1;
+        int c = (value >> 2) & 1;
+        int scale = 0;
+        int offset = 0;
+        if (range.trits)
+        {
+            static constexpr int Scales[4] = {0, 50, 23, 11};
+            scale = Scales[range.bits];
+            offset = range.bits == 2 ? b * 0x45 : range.bits == 3 ? (c << 6) | (b << 5) | (c << 1) | b : 0;
+        }
+        else
+        {
+            static constexpr int Scales[3] = {0, 28, 13};
+            scale = Scales[range.bits];
+            offset = range.bits == 2 ? (b << 6) | (b << 1) : 0;
+        }
+        int mask = a ? 0x7F : 0;
+        result = (mask & 0x20) | (((digit * scale + offset) ^ mask) >> 2);
+    }
+    return result > 32 ? result + 1 : result;
+}
+
+static bool DecodeBlockMode(uint32_t block_mode, int& width, int& height, bool& dual_plane, int& weight_range)
+{
+    int quant = (block_mode >> 4) & 1;
+    int precision = (block_mode >> 9) & 1;
+    dual_plane = (block_mode >> 10) & 1;
+    int a = (block_mode >> 5) & 3;
+    if (block_mode & 3)
+    {
+        quant |= (block_mode & 3) << 1;
+        int b = (block_mode >> 7) & 3;
+        switch ((block_mode >> 2) & 3)
+        {
+        case 0: width = b + 4; height = a + 2; break;
+        case 1: width = b + 8; height = a + 2; break;
+        case 2: width = a + 2; height = b + 8; break;
+        case 3:
+            b &= 1;
+            if (block_mode & 0x100)
+            {
+                width = b + 2;
+                height = a + 2;
+            }
+            else
+            {
+                width = a + 2;
+                height = b + 6;
+            }
+            break;
+        }
+    }
+    else
+    {
+        quant |= ((block_mode >> 2) & 3) << 1;
+        if (!((block_mode >> 2) & 3))
+        {
+            return false;
+        }
+        int b = (block_mode >> 9) & 3;
+        switch ((block_mode >> 7) & 3)
+        {
+        case 0: width = 12; height = a + 2; break;
+        case 1: width = a + 2; height = 12; break;
+        case 2:
+            width = a + 6;
+            height = b + 6;
+            dual_plane = false;
+            precision = 0;
+            break;
+        case 3:
+            if (a > 1)
+            {
+                return false;
+            }
+            width = a ? 10 : 6;
+            height = a ? 6 : 10;
+            break;
+        }
+    }
+    weight_range = quant - 2 + 6 * precision;
+    return true;
+}
+
+static uint32_t Hash52(uint32_t value)
+{
+    value ^= value >> 15;
+    value *= 0xEEDE0891;
+    value ^= value >> 5;
+    value += value << 16;
+    value ^= value >> 7;
+    value ^= value >> 3;
+    value ^= value << 6;
+    value ^= value >> 17;
+    return value;
+}
+
+static int SelectPartition(int seed, int x, int y, int num_partitions)
+{
+    /* blocks under 31 texels double their coordinates */
+    x <<= 1;
+    y <<= 1;
+    seed += (num_partitions - 1) * 1024;
+    uint32_t random = Hash52(seed);
+    uint32_t seeds[8];
+    for (int i = 0; i < 8; i++)
+    {
+        seeds[i] = (random >> (i * 4)) & 0xF;
+        seeds[i] *= seeds[i];
+    }
+    int shift1;
+    int shift2;
+    if (seed & 1)
+    {
+        shift1 = seed & 2 ? 4 : 5;
+        shift2 = num_partitions == 3 ? 6 : 5;
+    }
+    else
+    {
+        shift1 = num_partitions == 3 ? 6 : 5;
+        shift2 = seed & 2 ? 4 : 5;
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        seeds[i] >>= i % 2 ? shift2 : shift1;
+    }
+    uint32_t a = (seeds[0] * x + seeds[1] * y + (random >> 14)) & 0x3F;
+    uint32_t b = (seeds[2] * x + seeds[3] * y + (random >> 10)) & 0x3F;
+    uint32_t c = (seeds[4] * x + seeds[5] * y + (random >> 6)) & 0x3F;
+    uint32_t d = (seeds[6] * x + seeds[7] * y + (random >> 2)) & 0x3F;
+    if (num_partitions < 4)
+    {
+        d = 0;
+    }
+    if (num_partitions < 3)
+    {
+        c = 0;
+    }
+    if (a >= b && a >= c && a >= d)
+    {
+        return 0;
+    }
+    if (b >= c && b >= d)
+    {
+        return 1;
+    }
+    return c >= d ? 2 : 3;
+}
+
+static bool IsHdrEndpointMode(int cem)
+{
+    return cem == 2 || cem == 3 || cem == 7 || cem == 11 || cem == 14 || cem == 15;
+}
+
+static void TransferBits(int& a, int& b)
+{
+    b >>= 1;
+    b |= a & 0x80;
+    a >>= 1;
+    a &= 0x3F;
+    if (a & 0x20)
+    {
+        a -= 0x40;
+    }
+}
+
+static void SetEndpoint(uint8_t endpoint[4], int r, int g, int b, int a)
+{
+    endpoint[0] = std::clamp(r, 0, 255);
+    endpoint[1] = std::clamp(g, 0, 255);
+    endpoint[2] = std::clamp(b, 0, 255);
+    endpoint[3] = std::clamp(a, 0, 255);
+}
+
+static void SetContractedEndpoint(uint8_t endpoint[4], int r, int g, int b, int a)
+{
+    SetEndpoint(endpoint, (r + b) >> 1, (g + b) >> 1, b, a);
+}
+
+static void DecodeEndpoints(int cem, const uint8_t* values, uint8_t endpoints[2][4])
+{
+    int v[8];
+    std::copy_n(values, ((cem >> 2) + 1) * 2, v);
+    switch (cem)
+    {
+    case 0:
+        SetEndpoint(endpoints[0], v[0], v[0], v[0], 255);
+        SetEndpoint(endpoints[1], v[1], v[1], v[1], 255);
+        break;
+    case 1:
+    {
+        int l0 = (v[0] >> 2) | (v[1] & 0xC0);
+        int l1 = std::min(l0 + (v[1] & 0x3F), 255);
+        SetEndpoint(endpoints[0], l0, l0, l0, 255);
+        SetEndpoint(endpoints[1], l1, l1, l1, 255);
+        break;
+    }
+    case 4:
+        SetEndpoint(endpoints[0], v[0], v[0], v[0], v[2]);
+        SetEndpoint(endpoints[1], v[1], v[1], v[1], v[3]);
+        break;
+    case 5:
+        TransferBits(v[1], v[0]);
+        TransferBits(v[3], v[2]);
+        SetEndpoint(endpoints[0], v[0], v[0], v[0], v[2]);
+        SetEndpoint(endpoints[1], v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]);
+        break;
+    case 6:
+        SetEndpoint(endpoints[0], v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8, 255);
+        SetEndpoint(endpoints[1], v[0], v[1], v[2], 255);
+        break;
+    case 8:
+    case 12:
+    {
+        int a0 = cem == 12 ? v[6] : 255;
+        int a1 = cem == 12 ? v[7] : 255;
+        if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4])
+        {
+            SetEndpoint(endpoints[0], v[0], v[2], v[4], a0);
+            SetEndpoint(endpoints[1], v[1], v[3], v[5], a1);
+        }
+        else
+        {
+            SetContractedEndpoint(endpoints[0], v[1], v[3], v[5], a1);
+            SetContractedEndpoint(endpoints[1], v[0], v[2], v[4], a0);
+        }
+        break;
+    }
+    case 9:
+    case 13:
+    {
+        TransferBits(v[1], v[0]);
+        TransferBits(v[3], v[2]);
+        TransferBits(v[5], v[4]);
+        if (cem == 13)
+        {
+            TransferBits(v[7], v[6]);
+        }
+        else
+        {
+            v[6] = 255;
+            v[7] = 0;
+        }
+        if (v[1] + v[3] + v[5] >= 0)
+        {
+            SetEndpoint(endpoints[0], v[0], v[2], v[4], v[6]);
+            SetEndpoint(endpoints[1], v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+        }
+        else
+        {
+            SetContractedEndpoint(endpoints[0], v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+            SetContractedEndpoint(endpoints[1], v[0], v[2], v[4], v[6]);
+        }
+        break;
+    }
+    case 10:
+        SetEndpoint(endpoints[0], v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8, v[4]);
+        SetEndpoint(endpoints[1], v[0], v[1], v[2], v[5]);
+        break;
+    }
+}
+
+static int InfillWeight(const uint8_t* grid, int width, int height, int num_planes, int plane, int x, int y)
+{
+    /* bilinear over the weight grid, (1024 + 4 / 2) / (4 - 1) for 4x4 blocks */
+    static constexpr int Scale = 342;
+    int s = (Scale * x * (width - 1) + 32) >> 6;
+    int t = (Scale * y * (height - 1) + 32) >> 6;
+    int grid_x = s >> 4;
+    int grid_y = t >> 4;
+    int fraction_x = s & 0xF;
+    int fraction_y = t & 0xF;
+    auto Get = [&](int dx, int dy)
+    {
+        int i = std::min(grid_x + dx, width - 1);
+        int j = std::min(grid_y + dy, height - 1);
+        return grid[(j * width + i) * num_planes + plane];
+    };
+    int w11 = (fraction_x * fraction_y + 8) >> 4;
+    int w10 = fraction_y - w11;
+    int w01 = fraction_x - w11;
+    int w00 = 16 - fraction_x - fraction_y + w11;
+    return (Get(0, 0) * w00 + Get(1, 0) * w01 + Get(0, 1) * w10 + Get(1, 1) * w11 + 8) >> 4;
+}
+
+static void DecompressAstc(const uint8_t* block, uint8_t* texels)
+{
+    auto Fail = [texels]()
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            std::memcpy(texels + i * 4, AstcErrorColor, 4);
+        }
+    };
+    uint32_t block_mode = ReadBits(block, 0, 11);
+    if ((block_mode & 0x1FF) == 0x1FC)
+    {
+        /* void extent, one color for the whole block */
+        if (block_mode & 0x200)
+        {
+            Fail();
+            return;
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            uint8_t value = ReadBits(block, 64 + c * 16, 16) >> 8;
+            for (int i = 0; i < 16; i++)
+            {
+                texels[i * 4 + c] = value;
+            }
+        }
+        return;
+    }
+    int grid_width = 0;
+    int grid_height = 0;
+    bool dual_plane = false;
+    int weight_range = 0;
+    if (!DecodeBlockMode(block_mode, grid_width, grid_height, dual_plane, weight_range) || grid_width > 4 || grid_height > 4)
+    {
+        Fail();
+        return;
+    }
+    int num_planes = dual_plane ? 2 : 1;
+    int num_weights = grid_width * grid_height * num_planes;
+    const IseRange& weight_ise = IseRanges[weight_range];
+    int weight_bits = GetIseSize(weight_ise, num_weights);
+    int num_partitions = ReadBits(block, 11, 2) + 1;
+    if (weight_bits < 24 || weight_bits > 96 || (num_partitions == 4 && dual_plane))
+    {
+        Fail();
+        return;
+    }
+    int below_weights = 128 - weight_bits;
+    int cems[4] = {};
+    int seed = 0;
+    int color_offset = 17;
+    if (num_partitions == 1)
+    {
+        cems[0] = ReadBits(block, 13, 4);
+    }
+    else
+    {
+        seed = ReadBits(block, 13, 10);
+        color_offset = 29;
+        uint32_t cem = ReadBits(block, 23, 6);
+        if (!(cem & 3))
+        {
+            std::fill_n(cems, num_partitions, cem >> 2);
+        }
+        else
+        {
+            /* the class offsets and modes continue below the weights */
+            int extra_bits = 3 * num_partitions - 4;
+            below_weights -= extra_bits;
+            cem |= ReadBits(block, below_weights, extra_bits) << 6;
+            int base_class = (cem & 3) - 1;
+            cem >>= 2;
+            for (int i = 0; i < num_partitions; i++)
+            {
+                cems[i] = ((base_class + ((cem >> i) & 1)) << 2) | ((cem >> (num_partitions + i * 2)) & 3);
+            }
+        }
+    }
+    int plane_component = -1;
+    if (dual_plane)
+    {
+        below_weights -= 2;
+        plane_component = ReadBits(block, below_weights, 2);
+    }
+    int num_values = 0;
+    for (int i = 0; i < num_partitions; i++)
+    {
+        if (IsHdrEndpointMode(cems[i]))
+        {
+            Fail();
+            return;
+        }
+        num_values += ((cems[i] >> 2) + 1) * 2;
+    }
+    int color_range = 20;
+    while (color_range >= 0 && GetIseSize(IseRanges[color_range], num_values) > below_weights - color_offset)
+    {
+        color_range--;
+    }
+    /* fewer than six levels can't hold endpoints */
+    if (num_values > 18 || color_range < 4)
+    {
+        Fail();
+        return;
+    }
+    uint8_t bits[64];
+    uint8_t digits[64];
+    DecodeIse(block, color_offset, IseRanges[color_range], num_values, bits, digits);
+    uint8_t values[18];
+    for (int i = 0; i < num_values; i++)
+    {
+        values[i] = UnquantizeColor(IseRanges[color_range], bits[i], digits[i]);
+    }
+    uint8_t endpoints[4][2][4];
+    const uint8_t* partition_values = values;
+    for (int i = 0; i < num_partitions; i++)
+    {
+        DecodeEndpoints(cems[i], partition_values, endpoints[i]);
+        partition_values += ((cems[i] >> 2) + 1) * 2;
+    }
+    /* weights are stored bit reversed from the end of the block */
+    uint8_t reversed[16];
+    for (int i = 0; i < 16; i++)
+    {
+        uint8_t value = block[15 - i];
+        value = ((value & 0xF0) >> 4) | ((value & 0x0F) << 4);
+        value = ((value & 0xCC) >> 2) | ((value & 0x33) << 2);
+        value = ((value & 0xAA) >> 1) | ((value & 0x55) << 1);
+        reversed[i] = value;
+    }
+    DecodeIse(reversed, 0, weight_ise, num_weights, bits, digits);
+    uint8_t grid[64];
+    for (int i = 0; i < num_weights; i++)
+    {
+        grid[i] = UnquantizeWeight(weight_ise, bits[i], digits[i]);
+    }
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            int partition = num_partitions > 1 ? SelectPartition(seed, x, y, num_partitions) : 0;
+            int weights[2];
+            for (int plane = 0; plane < num_planes; plane++)
+            {
+                weights[plane] = InfillWeight(grid, grid_width, grid_height, num_planes, plane, x, y);
+            }
+            uint8_t* texel = texels + (y * 4 + x) * 4;
+            for (int c = 0; c < 4; c++)
+            {
+                int weight = weights[c == plane_component];
+                int value1 = endpoints[partition][0][c] * 257;
+                int value2 = endpoints[partition][1][c] * 257;
+                texel[c] = (((64 - weight) * value1 + weight * value2 + 32) >> 6) >> 8;
+            }
+        }
+    }
+}
+
+static uint32_t GetBlockSize(SDL_GPUTextureFormat format)
+{
+    return format == SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM || format == SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM ? 8 : 16;
+}
+
+bool CanDecompress(SDL_GPUTextureFormat format)
+{
+    switch (format)
+    {
+    case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM:
+        return true;
+    }
+    return false;
+}
+
+void Decompress(SDL_GPUTextureFormat format, const uint8_t* src_data, uint32_t width, uint32_t height, uint8_t* dst_data)
+{
+    uint32_t block_bytes = GetBlockSize(format);
+    for (uint32_t block_y = 0; block_y < height; block_y += 4)
+    {
+        for (uint32_t block_x = 0; block_x < width; block_x += 4)
+        {
+            uint8_t texels[64];
+            switch (format)
+            {
+            case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+                DecompressColor(src_data, texels, false);
+                break;
+            case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:
+                DecompressColor(src_data + 8, texels, true);
+                for (int i = 0; i < 16; i++)
+                {
+                    texels[i * 4 + 3] = ((src_data[i / 2] >> (i % 2 * 4)) & 0xF) * 17;
+                }
+                break;
+            case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+                DecompressColor(src_data + 8, texels, true);
+                DecompressAlpha(src_data, texels, 3);
+                break;
+            case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+            case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:
+                /* sampled like the block format, with zero green and blue */
+                for (int i = 0; i < 16; i++)
+                {
+                    texels[i * 4 + 1] = 0;
+                    texels[i * 4 + 2] = 0;
+                    texels[i * 4 + 3] = 255;
+                }
+                DecompressAlpha(src_data, texels, 0);
+                if (format == SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM)
+                {
+                    DecompressAlpha(src_data + 8, texels, 1);
+                }
+                break;
+            case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:
+                DecompressBc7(src_data, texels);
+                break;
+            default:
+                DecompressAstc(src_data, texels);
+                break;
+            }
+            for (uint32_t y = 0; y < 4 && block_y + y < height; y++)
+            {
+                uint32_t num_texels = std::min(4u, width - block_x);
+                std::memcpy(dst_data + ((block_y + y) * width + block_x) * 4, texels + y * 16, num_texels * 4);
+            }
+            src_data += block_bytes;
+        }
+    }
+}
+
+static void FitLine(const uint8_t* texels, int num_channels, float endpoints[2][4])
+{
+    /* the principal axis through the texels, clamped to the extent of their projections */
+    float mean[4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < num_channels; c++)
+        {
+            mean[c] += texels[i * 4 + c] / 16.0f;
+        }
+    }
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int j = 0; j < num_channels; j++)
+        {
+            for (int k = 0; k < num_channels; k++)
+            {
+                covariance[j][k] += (texels[i * 4 + j] - mean[j]) * (texels[i * 4 + k] - mean[k]);
+            }
+        }
+    }
+    int largest = 0;
+    for (int c = 1; c < num_channels; c++)
+    {
+        if (covariance[c][c] > covariance[largest][largest])
+        {
+            largest = c;
+        }
+    }
+    float axis[4] = {};
+    std::copy_n(covariance[largest], num_channels, axis);
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = {};
+        float scale = 0.0f;
+        for (int j = 0; j < num_channels; j++)
+        {
+            for (int k = 0; k < num_channels; k++)
+            {
+                next[j] += covariance[j][k] * axis[k];
+            }
+            scale = std::max(scale, std::abs(next[j]));
+        }
+        if (scale == 0.0f)
+        {
+            break;
+        }
+        for (int c = 0; c < num_channels; c++)
+        {
+            axis[c] = next[c] / scale;
+        }
+    }
+    float length = 0.0f;
+    for (int c = 0; c < num_channels; c++)
+    {
+        length += axis[c] * axis[c];
+    }
+    float min = 0.0f;
+    float max = 0.0f;
+    if (length > 0.0f)
+    {
+        length = std::sqrt(length);
+        for (int c = 0; c < num_channels; c++)
+        {
+            axis[c] /= length;
+        }
+        min = 1e9f;
+        max = -1e9f;
+        for (int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < num_channels; c++)
+            {
+                t += (texels[i * 4 + c] - mean[c]) * axis[c];
+            }
+            min = std::min(min, t);
+            max = std::max(max, t);
+        }
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        endpoints[0][c] = c < num_channels ? std::clamp(mean[c] + axis[c] * min, 0.0f, 255.0f) : 255.0f;
+        endpoints[1][c] = c < num_channels ? std::clamp(mean[c] + axis[c] * max, 0.0f, 255.0f) : 255.0f;
+    }
+}
+
+static void RefineLine(const uint8_t* texels, int num_channels, const int weights[16], float endpoints[2][4])
+{
+    /* least squares endpoints for the weights the texels were given */
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float b = weights[i] / 64.0f;
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < num_channels; c++)
+        {
+            ax[c] += a * texels[i * 4 + c];
+            bx[c] += b * texels[i * 4 + c];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f)
+    {
+        return;
+    }
+    for (int c = 0; c < num_channels; c++)
+    {
+        endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+        endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+    }
+}
+
+static int FindNearest(const uint8_t* texel, const uint8_t (*palette)[4], int num_colors, int first_channel, int num_channels, int& error)
+{
+    int nearest = 0;
+    error = INT32_MAX;
+    for (int i = 0; i < num_colors; i++)
+    {
+        int candidate_error = 0;
+        for (int c = first_channel; c < first_channel + num_channels; c++)
+        {
+            int delta = texel[c] - palette[i][c];
+            candidate_error += delta * delta;
+        }
+        if (candidate_error < error)
+        {
+            nearest = i;
+            error = candidate_error;
+        }
+    }
+    return nearest;
+}
+
+static int FindIndices(const uint8_t* texels, const uint8_t (*palette)[4], int num_colors, int first_channel, int num_channels, int indices[16])
+{
+    int total_error = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int error;
+        indices[i] = FindNearest(texels + i * 4, palette, num_colors, first_channel, num_channels, error);
+        total_error += error;
+    }
+    return total_error;
+}
+
+template<typename Encode>
+static void EncodeLine(const uint8_t* texels, int num_channels, Encode encode)
+{
+    /* the principal axis, then one least squares pass, keeping whichever is closer */
+    float endpoints[2][4];
+    FitLine(texels, num_channels, endpoints);
+    int weights[16];
+    int error = encode(endpoints, weights, false);
+    RefineLine(texels, num_channels, weights, endpoints);
+    if (encode(endpoints, weights, false) >= error)
+    {
+        FitLine(texels, num_channels, endpoints);
+    }
+    encode(endpoints, weights, true);
+}
+
+static void CompressBc3(const uint8_t* texels, uint8_t* block)
+{
+    uint8_t min_alpha = 255;
+    uint8_t max_alpha = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        min_alpha = std::min(min_alpha, texels[i * 4 + 3]);
+        max_alpha = std::max(max_alpha, texels[i * 4 + 3]);
+    }
+    block[0] = max_alpha;
+    block[1] = min_alpha;
+    uint8_t alphas[8];
+    GetAlphas(block, alphas);
+    uint64_t alpha_indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int nearest = 0;
+        for (int j = 1; j < 8; j++)
+        {
+            if (std::abs(texels[i * 4 + 3] - alphas[j]) < std::abs(texels[i * 4 + 3] - alphas[nearest]))
+            {
+                nearest = j;
+            }
+        }
+        alpha_indices |= uint64_t(nearest) << (i * 3);
+    }
+    std::memcpy(block + 2, &alpha_indices, 6);
+    EncodeLine(texels, 3, [texels, block](const float endpoints[2][4], int weights[16], bool write)
+    {
+        static constexpr int Weights[4] = {0, 64, 21, 43};
+        uint16_t colors[2];
+        for (int i = 0; i < 2; i++)
+        {
+            colors[i] = (uint16_t(std::lround(endpoints[i][0] * 31 / 255)) << 11) |
+                        (uint16_t(std::lround(endpoints[i][1] * 63 / 255)) << 5) |
+                        (uint16_t(std::lround(endpoints[i][2] * 31 / 255)) << 0);
+        }
+        bool swapped = colors[0] < colors[1];
+        if (swapped)
+        {
+            std::swap(colors[0], colors[1]);
+        }
+        std::memcpy(block + 8, colors, 4);
+        /* indices 0 to 3 along each row give the palette in the first four texels */
+        std::memset(block + 12, 0xE4, 4);
+        uint8_t palette[16][4];
+        DecompressColor(block + 8, palette[0], true);
+        int indices[16];
+        int error = FindIndices(texels, palette, 4, 0, 3, indices);
+        uint32_t color_indices = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            weights[i] = swapped ? 64 - Weights[indices[i]] : Weights[indices[i]];
+            color_indices |= uint32_t(indices[i]) << (i * 2);
+        }
+        if (write)
+        {
+            std::memcpy(block + 12, &color_indices, 4);
+        }
+        return error;
+    });
+}
+
+static void CompressBc7(const uint8_t* texels, uint8_t* block)
+{
+    std::memset(block, 0, 16);
+    bool constant_alpha = true;
+    for (int i = 0; i < 16; i++)
+    {
+        constant_alpha &= texels[i * 4 + 3] == texels[3];
+    }
+    if (constant_alpha)
+    {
+        /* mode 6, one RGBA line with 4 bit indices */
+        EncodeLine(texels, 4, [texels, block](const float endpoints[2][4], int weights[16], bool write)
+        {
+            int quantized[2][4];
+            int pbits[2];
+            uint8_t values[2][4];
+            for (int e = 0; e < 2; e++)
+            {
+                float best_error = FLT_MAX;
+                for (int p = 0; p < 2; p++)
+                {
+                    float error = 0.0f;
+                    int candidate[4];
+                    for (int c = 0; c < 4; c++)
+                    {
+                        candidate[c] = std::clamp(int(std::lround((endpoints[e][c] - p) / 2)), 0, 127);
+                        float delta = (candidate[c] * 2 + p) - endpoints[e][c];
+                        error += delta * delta;
+                    }
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        pbits[e] = p;
+                        std::copy_n(candidate, 4, quantized[e]);
+                    }
+                }
+                for (int c = 0; c < 4; c++)
+                {
+                    values[e][c] = quantized[e][c] * 2 + pbits[e];
+                }
+            }
+            uint8_t palette[16][4];
+            for (int i = 0; i < 16; i++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    palette[i][c] = Interpolate(values[0][c], values[1][c], Weights4[i]);
+                }
+            }
+            int indices[16];
+            int error = FindIndices(texels, palette, 16, 0, 4, indices);
+            for (int i = 0; i < 16; i++)
+            {
+                weights[i] = Weights4[indices[i]];
+            }
+            if (!write)
+            {
+                return error;
+            }
+            /* the first texel's index drops its high bit */
+            if (indices[0] >= 8)
+            {
+                std::swap(quantized[0], quantized[1]);
+                std::swap(pbits[0], pbits[1]);
+                for (int& index : indices)
+                {
+                    index = 15 - index;
+                }
+            }
+            uint32_t offset = 0;
+            WriteBits(block, offset, 1 << 6, 7);
+            for (int c = 0; c < 4; c++)
+            {
+                WriteBits(block, offset, quantized[0][c], 7);
+                WriteBits(block, offset, quantized[1][c], 7);
+            }
+            WriteBits(block, offset, pbits[0], 1);
+            WriteBits(block, offset, pbits[1], 1);
+            for (int i = 0; i < 16; i++)
+            {
+                WriteBits(block, offset, indices[i], i ? 4 : 3);
+            }
+            return error;
+        });
+        return;
+    }
+    /* mode 5, an RGB line and a separate alpha line with 2 bit indices each */
+    int alphas[2] = {255, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        alphas[0] = std::min<int>(alphas[0], texels[i * 4 + 3]);
+        alphas[1] = std::max<int>(alphas[1], texels[i * 4 + 3]);
+    }
+    EncodeLine(texels, 3, [texels, block, &alphas](const float endpoints[2][4], int weights[16], bool write)
+    {
+        int quantized[2][4];
+        uint8_t palette[4][4];
+        for (int e = 0; e < 2; e++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                quantized[e][c] = std::lround(endpoints[e][c] * 127 / 255);
+            }
+            quantized[e][3] = alphas[e];
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                palette[i][c] = Interpolate(Replicate(quantized[0][c], 7, 8), Replicate(quantized[1][c], 7, 8), Weights2[i]);
+            }
+            palette[i][3] = Interpolate(quantized[0][3], quantized[1][3], Weights2[i]);
+        }
+        int color_indices[16];
+        int alpha_indices[16];
+        int error = FindIndices(texels, palette, 4, 0, 3, color_indices);
+        for (int i = 0; i < 16; i++)
+        {
+            weights[i] = Weights2[color_indices[i]];
+        }
+        if (!write)
+        {
+            return error;
+        }
+        FindIndices(texels, palette, 4, 3, 1, alpha_indices);
+        if (color_indices[0] >= 2)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                std::swap(quantized[0][c], quantized[1][c]);
+            }
+            for (int& index : color_indices)
+            {
+                index = 3 - index;
+            }
+        }
+        if (alpha_indices[0] >= 2)
+        {
+            std::swap(quantized[0][3], quantized[1][3]);
+            for (int& index : alpha_indices)
+            {
+                index = 3 - index;
+            }
+        }
+        uint32_t offset = 0;
+        WriteBits(block, offset, 1 << 5, 6);
+        WriteBits(block, offset, 0, 2);
+        for (int c = 0; c < 4; c++)
+        {
+            WriteBits(block, offset, quantized[0][c], c < 3 ? 7 : 8);
+            WriteBits(block, offset, quantized[1][c], c < 3 ? 7 : 8);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            WriteBits(block, offset, color_indices[i], i ? 2 : 1);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            WriteBits(block, offset, alpha_indices[i], i ? 2 : 1);
+        }
+        return error;
+    });
+}
+
+static void CompressAstc(const uint8_t* texels, uint8_t* block)
+{
+    /*
+     * A single partition over the full 4x4 weight grid with 8 bit endpoints.
+     * Opaque blocks use RGB direct (mode 8) with 3 bit weights and the rest
+     * RGBA direct (mode 12) with 2 bit weights, so neither needs trits or quints.
+     */
+    std::memset(block, 0, 16);
+    bool opaque = true;
+    for (int i = 0; i < 16; i++)
+    {
+        opaque &= texels[i * 4 + 3] == 255;
+    }
+    int num_channels = opaque ? 3 : 4;
+    int weight_bits = opaque ? 3 : 2;
+    EncodeLine(texels, num_channels, [=](const float endpoints[2][4], int weights[16], bool write)
+    {
+        uint8_t values[2][4];
+        for (int e = 0; e < 2; e++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                values[e][c] = std::lround(endpoints[e][c]);
+            }
+        }
+        /* a smaller second endpoint would be read as blue contracted */
+        bool swapped = values[1][0] + values[1][1] + values[1][2] < values[0][0] + values[0][1] + values[0][2];
+        if (swapped)
+        {
+            std::swap(values[0], values[1]);
+        }
+        uint8_t palette[8][4];
+        for (int i = 0; i < (1 << weight_bits); i++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                int weight = GetWeights(weight_bits)[i];
+                palette[i][c] = (((64 - weight) * values[0][c] * 257 + weight * values[1][c] * 257 + 32) >> 6) >> 8;
+            }
+        }
+        int indices[16];
+        int error = FindIndices(texels, palette, 1 << weight_bits, 0, num_channels, indices);
+        for (int i = 0; i < 16; i++)
+        {
+            weights[i] = swapped ? 64 - GetWeights(weight_bits)[indices[i]] : GetWeights(weight_bits)[indices[i]];
+        }
+        if (!write)
+        {
+            return error;
+        }
+        uint32_t offset = 0;
+        WriteBits(block, offset, opaque ? 0x53 : 0x42, 11);
+        WriteBits(block, offset, 0, 2);
+        WriteBits(block, offset, opaque ? 8 : 12, 4);
+        for (int c = 0; c < num_channels; c++)
+        {
+            WriteBits(block, offset, values[0][c], 8);
+            WriteBits(block, offset, values[1][c], 8);
+        }
+        /* weights run backwards from the end of the block */
+        for (int i = 0; i < 16; i++)
+        {
+            for (int j = 0; j < weight_bits; j++)
+            {
+                int bit = 127 - (i * weight_bits + j);
+                block[bit / 8] |= ((indices[i] >> j) & 1) << (bit % 8);
+            }
+        }
+        return error;
+    });
+}
+
+bool CanCompress(SDL_GPUTextureFormat format)
+{
+    return format == SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM ||
+           format == SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM ||
+           format == SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM;
+}
+
+void Compress(SDL_GPUTextureFormat format, const uint8_t* src_data, uint32_t width, uint32_t height, uint8_t* dst_data)
+{
+    for (uint32_t block_y = 0; block_y < height; block_y += 4)
+    {
+        for (uint32_t block_x = 0; block_x < width; block_x += 4)
+        {
+            /* partial blocks repeat their last row and column */
+            uint8_t texels[64];
+            for (uint32_t y = 0; y < 4; y++)
+            {
+                for (uint32_t x = 0; x < 4; x++)
+                {
+                    uint32_t src_x = std::min(block_x + x, width - 1);
+                    uint32_t src_y = std::min(block_y + y, height - 1);
+                    std::memcpy(texels + (y * 4 + x) * 4, src_data + (src_y * width + src_x) * 4, 4);
+                }
+            }
+            switch (format)
+            {
+            case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+                CompressBc3(texels, dst_data);
+                break;
+            case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:
+                CompressBc7(texels, dst_data);
+                break;
+            default:
+                CompressAstc(texels, dst_data);
+                break;
+            }
+            dst_data += 16;
+        }
+    }
+}
@@ -0,0 +1,273 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "internal.hpp"
+
+struct Block
+{
+    SDL_GPUTransferBuffer* transfer_buffer;
+    uint8_t* data;
+    uint32_t size;
+    uint32_t used;
+    uint64_t submission;
+};
+
+struct SDLx_ModelUploader
+{
+    SDL_GPUDevice* device;
+    uint32_t block_size;
+    std::vector<Block> blocks;
+    size_t current;
+    uint64_t submission;
+    uint64_t completed;
+    std::deque<std::pair<uint64_t, SDL_GPUFence*>> fences;
+    std::vector<std::pair<SDL_GPUTransferBufferLocation, SDL_GPUBufferRegion>> buffer_uploads;
+    std::vector<std::pair<SDL_GPUTextureTransferInfo, SDL_GPUTextureRegion>> texture_uploads;
+    std::vector<std::pair<Model*, SharedResources>> shared;
+};
+
+static void Recycle(SDLx_ModelUploader* uploader)
+{
+    while (!uploader->fences.empty())
+    {
+        auto [submission, fence] = uploader->fences.front();
+        if (!SDL_QueryGPUFence(uploader->device, fence))
+        {
+            break;
+        }
+        SDL_ReleaseGPUFence(uploader->device, fence);
+        uploader->fences.pop_front();
+        uploader->completed = submission;
+    }
+    for (Block& block : uploader->blocks)
+    {
+        if (block.submission && block.submission <= uploader->completed)
+        {
+            block.used = 0;
+            block.submission = 0;
+        }
+    }
+}
+
+static Block* Acquire(SDLx_ModelUploader* uploader, uint32_t size)
+{
+    Recycle(uploader);
+    for (size_t i = 1; i <= uploader->blocks.size(); i++)
+    {
+        size_t index = (uploader->current + i) % uploader->blocks.size();
+        Block& block = uploader->blocks[index];
+        if (!block.used && !block.submission && block.size >= size)
+        {
+            uploader->current = index;
+            return &block;
+        }
+    }
+    Block block{};
+    block.size = std::max(uploader->block_size, size);
+    {
+        SDL_GPUTransferBufferCreateInfo info{};
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        info.size = block.size;
+        block.transfer_buffer = SDL_CreateGPUTransferBuffer(uploader->device, &info);
+        if (!block.transfer_buffer)
+        {
+            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+            return nullptr;
+        }
+    }
+    uploader->current = uploader->blocks.empty() ? 0 : uploader->current + 1;
+    uploader->blocks.insert(uploader->blocks.begin() + uploader->current, block);
+    return &uploader->blocks[uploader->current];
+}
+
+uint8_t* AllocateUploader(SDLx_ModelUploader* uploader, uint32_t size, uint32_t alignment, SDL_GPUTransferBuffer*& transfer_buffer, uint32_t& offset)
+{
+    Block* block = nullptr;
+    if (!uploader->blocks.empty())
+    {
+        block = &uploader->blocks[uploader->current];
+        offset = (block->used + alignment - 1) / alignment * alignment;
+        if (block->submission || !block->data || offset + size > block->size)
+        {
+            block = nullptr;
+        }
+    }
+    if (!block)
+    {
+        block = Acquire(uploader, size);
+        if (!block)
+        {
+            return nullptr;
+        }
+        offset = 0;
+    }
+    if (!block->data)
+    {
+        block->data = static_cast<uint8_t*>(SDL_MapGPUTransferBuffer(uploader->device, block->transfer_buffer, false));
+        if (!block->data)
+        {
+            SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+            return nullptr;
+        }
+    }
+    block->used = offset + size;
+    transfer_buffer = block->transfer_buffer;
+    return block->data + offset;
+}
+
+SDLx_ModelUploader* SDLx_ModelCreateUploader(SDL_GPUDevice* device, Uint32 block_size)
+{
+    if (!device)
+    {
+        SDL_InvalidParamError("device");
+        return nullptr;
+    }
+    SDLx_ModelUploader* uploader = new SDLx_ModelUploader();
+    if (!uploader)
+    {
+        SDL_SetError("Failed to allocate uploader");
+        return nullptr;
+    }
+    uploader->device = device;
+    uploader->block_size = block_size;
+    return uploader;
+}
+
+SDLx_Model* SDLx_ModelLoadQueued(SDLx_ModelUploader* uploader, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags)
+{
+    if (!uploader)
+    {
+        SDL_InvalidParamError("uploader");
+        return nullptr;
+    }
+    SDLx_ModelData* data = DecodeModel(uploader->device, path, type, flags);
+    if (!data)
+    {
+        return nullptr;
+    }
+    SDLx_Model* model = SDLx_ModelUploadQueued(uploader, data);
+    SDLx_ModelDestroyData(data);
+    return model;
+}
+
+SDLx_Model* SDLx_ModelUploadQueued(SDLx_ModelUploader* uploader, const SDLx_ModelData* data)
+{
+    if (!uploader)
+    {
+        SDL_InvalidParamError("uploader");
+        return nullptr;
+    }
+    if (!data)
+    {
+        SDL_InvalidParamError("data");
+        return nullptr;
+    }
+    Staging staging{};
+    staging.device = uploader->device;
+    staging.uploader = uploader;
+    Model* model = StageModel(staging, data);
+    if (!model)
+    {
+        return nullptr;
+    }
+    uploader->buffer_uploads.insert(uploader->buffer_uploads.end(), staging.buffer_uploads.begin(), staging.buffer_uploads.end());
+    uploader->texture_uploads.insert(uploader->texture_uploads.end(), staging.texture_uploads.begin(), staging.texture_uploads.end());
+    uploader->shared.emplace_back(model, std::move(staging.shared));
+    return model;
+}
+
+bool SDLx_ModelSubmitUploader(SDLx_ModelUploader* uploader)
+{
+    if (!uploader)
+    {
+        SDL_InvalidParamError("uploader");
+        return false;
+    }
+    if (uploader->buffer_uploads.empty() && uploader->texture_uploads.empty())
+    {
+        return true;
+    }
+    SDL_GPUCommandBuffer* command_buffer = SDL_AcquireGPUCommandBuffer(uploader->device);
+    if (!command_buffer)
+    {
+        SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+        return false;
+    }
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    if (!copy_pass)
+    {
+        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(command_buffer);
+        return false;
+    }
+    for (Block& block : uploader->blocks)
+    {
+        if (block.data)
+        {
+            SDL_UnmapGPUTransferBuffer(uploader->device, block.transfer_buffer);
+            block.data = nullptr;
+        }
+    }
+    for (const auto& [location, region] : uploader->buffer_uploads)
+    {
+        SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
+    }
+    for (const auto& [info, region] : uploader->texture_uploads)
+    {
+        SDL_UploadToGPUTexture(copy_pass, &info, &region, true);
+    }
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+    if (!fence)
+    {
+        /* the copies stay queued and their blocks reserved, so the next submit retries them */
+        SDL_Log("Failed to submit command buffer: %s", SDL_GetError());
+        return false;
+    }
+    /* blocks written since the last submit, including those of a failed one */
+    uint64_t submission = ++uploader->submission;
+    for (Block& block : uploader->blocks)
+    {
+        if (block.used && !block.submission)
+        {
+            block.submission = submission;
+        }
+    }
+    uploader->fences.emplace_back(submission, fence);
+    uploader->buffer_uploads.clear();
+    uploader->texture_uploads.clear();
+    for (const auto& [model, shared] : uploader->shared)
+    {
+        PublishShared(model, uploader->device, shared);
+    }
+    uploader->shared.clear();
+    return true;
+}
+
+void SDLx_ModelDestroyUploader(SDLx_ModelUploader* uploader)
+{
+    if (!uploader)
+    {
+        return;
+    }
+    for (auto [submission, fence] : uploader->fences)
+    {
+        SDL_WaitForGPUFences(uploader->device, true, &fence, 1);
+        SDL_ReleaseGPUFence(uploader->device, fence);
+    }
+    for (Block& block : uploader->blocks)
+    {
+        if (block.data)
+        {
+            SDL_UnmapGPUTransferBuffer(uploader->device, block.transfer_buffer);
+        }
+        SDL_ReleaseGPUTransferBuffer(uploader->device, block.transfer_buffer);
+    }
+    delete uploader;
+}
\ No newline at end of file
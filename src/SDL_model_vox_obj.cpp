@@ -1,19 +1,59 @@
 #include <SDL3/SDL.h>
 #include <SDLx_model/SDL_model.h>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <limits>
 #include <unordered_map>
+#include <vector>
 
 #include "internal.hpp"
 #include "tiny_obj_loader.h"
 
-static SDLx_ModelVoxObjVertex Parse(SDLx_Model* model, const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
+static constexpr int PositionScale = 10;
+static constexpr int TexcoordScale = 255;
+
+static SDLx_ModelVoxObjVertex Pack(int position_x, int position_y, int position_z, uint64_t normal, uint64_t texcoord)
+{
+    uint64_t magnitude_x = std::abs(position_x);
+    uint64_t direction_x = position_x < 0 ? 1 : 0;
+    uint64_t magnitude_y = std::abs(position_y);
+    uint64_t direction_y = position_y < 0 ? 1 : 0;
+    uint64_t magnitude_z = std::abs(position_z);
+    uint64_t direction_z = position_z < 0 ? 1 : 0;
+    SDL_assert(magnitude_x < 256);
+    SDL_assert(magnitude_y < 256);
+    SDL_assert(magnitude_z < 256);
+    SDL_assert(normal < 6);
+    SDL_assert(texcoord < 256);
+    SDLx_ModelVoxObjVertex vertex{};
+    vertex |= (magnitude_x & 0xFF) << 0;
+    vertex |= (direction_x & 0x01) << 8;
+    vertex |= (magnitude_y & 0xFF) << 9;
+    vertex |= (direction_y & 0x01) << 17;
+    vertex |= (magnitude_z & 0xFF) << 18;
+    vertex |= (direction_z & 0x01) << 26;
+    vertex |= (normal & 0x07) << 32;
+    vertex |= (texcoord & 0xFF) << 35;
+    return vertex;
+}
+
+static SDLx_ModelVec3 Unpack(SDLx_ModelVoxObjVertex vertex)
+{
+    float position[3];
+    for (int i = 0; i < 3; i++)
+    {
+        float magnitude = (vertex >> (i * 9)) & 0xFF;
+        position[i] = (vertex >> (i * 9 + 8)) & 0x01 ? -magnitude : magnitude;
+    }
+    return {position[0], position[1], position[2]};
+}
+
+static SDLx_ModelVoxObjVertex Parse(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
 {
-    static constexpr int PositionScale = 10;
-    static constexpr int TexcoordScale = 255;
     int position_x = attrib.vertices[index.vertex_index * 3 + 0] * PositionScale;
     int position_y = attrib.vertices[index.vertex_index * 3 + 1] * PositionScale;
     int position_z = attrib.vertices[index.vertex_index * 3 + 2] * PositionScale;
@@ -21,13 +61,7 @@ static SDLx_ModelVoxObjVertex Parse(SDLx_Model* model, const tinyobj::attrib_t&
     int normal_y = attrib.normals[index.normal_index * 3 + 1];
     int normal_z = attrib.normals[index.normal_index * 3 + 2];
     uint64_t texcoord = attrib.texcoords[index.texcoord_index * 2 + 0] * TexcoordScale;
-    uint64_t magnitude_x = std::abs(position_x);
-    uint64_t direction_x = position_x < 0 ? 1 : 0;
-    uint64_t magnitude_y = std::abs(position_y);
-    uint64_t direction_y = position_y < 0 ? 1 : 0;
-    uint64_t magnitude_z = std::abs(position_z);
-    uint64_t direction_z = position_z < 0 ? 1 : 0;
-    uint64_t normal;
+    uint64_t normal = 0;
     if (normal_x < 0)
     {
         normal = 0;
@@ -56,29 +90,59 @@ static SDLx_ModelVoxObjVertex Parse(SDLx_Model* model, const tinyobj::attrib_t&
     {
         SDL_assert(false);
     }
-    SDL_assert(magnitude_x < 256);
-    SDL_assert(magnitude_y < 256);
-    SDL_assert(magnitude_z < 256);
-    SDL_assert(texcoord < 256);
-    model->min.x = std::min(float(position_x), model->min.x);
-    model->min.y = std::min(float(position_y), model->min.y);
-    model->min.z = std::min(float(position_z), model->min.z);
-    model->max.x = std::max(float(position_x), model->max.x);
-    model->max.y = std::max(float(position_y), model->max.y);
-    model->max.z = std::max(float(position_z), model->max.z);
-    SDLx_ModelVoxObjVertex vertex{};
-    vertex |= (magnitude_x & 0xFF) << 0;
-    vertex |= (direction_x & 0x01) << 8;
-    vertex |= (magnitude_y & 0xFF) << 9;
-    vertex |= (direction_y & 0x01) << 17;
-    vertex |= (magnitude_z & 0xFF) << 18;
-    vertex |= (direction_z & 0x01) << 26;
-    vertex |= (normal & 0x07) << 32;
-    vertex |= (texcoord & 0xFF) << 35;
-    return vertex;
+    return Pack(position_x, position_y, position_z, normal, texcoord);
 }
 
-bool LoadVoxObj(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, std::filesystem::path& path)
+/* reorders the triangles, then the vertices in place, in the order the triangles use them */
+static void Optimize(Data* data)
+{
+    SDLx_ModelVoxObjData& vox_obj = data->vox_obj;
+    std::vector<uint32_t> indices(vox_obj.num_indices / 3 * 3);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (vox_obj.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            indices[i] = static_cast<const uint16_t*>(vox_obj.indices)[i];
+        }
+        else
+        {
+            indices[i] = static_cast<const uint32_t*>(vox_obj.indices)[i];
+        }
+    }
+    std::vector<SDLx_ModelVec3> positions(vox_obj.num_vertices);
+    for (uint32_t i = 0; i < vox_obj.num_vertices; i++)
+    {
+        positions[i] = Unpack(vox_obj.vertices[i]);
+    }
+    VertexCacheStats source_stats{};
+    source_stats.Analyze(indices, vox_obj.num_vertices);
+    OptimizeIndices(indices, positions.data(), vox_obj.num_vertices);
+    std::vector<uint32_t> order = OptimizeVertexFetch(indices, vox_obj.num_vertices);
+    VertexCacheStats stats{};
+    stats.Analyze(indices, order.size());
+    std::vector<SDLx_ModelVoxObjVertex> vertices(vox_obj.vertices, vox_obj.vertices + vox_obj.num_vertices);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        vox_obj.vertices[i] = vertices[order[i]];
+    }
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (vox_obj.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+        {
+            static_cast<uint16_t*>(vox_obj.indices)[i] = indices[i];
+        }
+        else
+        {
+            static_cast<uint32_t*>(vox_obj.indices)[i] = indices[i];
+        }
+    }
+    vox_obj.num_vertices = order.size();
+    vox_obj.num_indices = indices.size();
+    data->source_index_stats = source_stats.Get();
+    data->index_stats = stats.Get();
+}
+
+bool DecodeVoxObj(Data* data, std::filesystem::path& path)
 {
     tinyobj::ObjReader reader;
     if (!reader.ParseFromFile(path.replace_extension(".obj").string()))
@@ -90,85 +154,412 @@ bool LoadVoxObj(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_
     const tinyobj::shape_t& shape = reader.GetShapes()[0];
     uint32_t max_num_indices = shape.mesh.num_face_vertices.size() * 3;
     SDL_assert(max_num_indices <= std::numeric_limits<uint16_t>::max());
-    SDL_GPUTransferBuffer* vertex_transfer_buffer;
-    SDL_GPUTransferBuffer* index_transfer_buffer;
-    {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = max_num_indices * sizeof(SDLx_ModelVoxObjVertex);
-        vertex_transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        info.size = max_num_indices * sizeof(uint16_t);
-        index_transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!vertex_transfer_buffer || !index_transfer_buffer)
-        {
-            SDL_Log("Failed to create transfer buffer(s): %s, %s", path.string().data(), SDL_GetError());
-            return false;
-        }
-    }
-    SDLx_ModelVoxObjVertex* vertex_data = static_cast<SDLx_ModelVoxObjVertex*>(SDL_MapGPUTransferBuffer(device, vertex_transfer_buffer, false));
-    uint16_t* index_data = static_cast<uint16_t*>(SDL_MapGPUTransferBuffer(device, index_transfer_buffer, false));
+    SDLx_ModelVoxObjVertex* vertex_data = data->Allocate<SDLx_ModelVoxObjVertex>(max_num_indices);
+    uint16_t* index_data = data->Allocate<uint16_t>(max_num_indices);
     if (!vertex_data || !index_data)
     {
-        SDL_Log("Failed to map transfer buffer(s): %s, %s", path.string().data(), SDL_GetError());
+        SDL_Log("Failed to allocate vertices and indices: %s", path.string().data());
         return false;
     }
     uint32_t num_vertices = 0;
-    model->vox_obj.num_indices = 0;
+    uint32_t num_indices = 0;
     std::unordered_map<SDLx_ModelVoxObjVertex, uint16_t> vertex_to_index;
     for (uint16_t i = 0; i < max_num_indices; i++)
     {
         tinyobj::index_t index = shape.mesh.indices[i];
-        SDLx_ModelVoxObjVertex vertex = Parse(model, attrib, index);
+        SDLx_ModelVoxObjVertex vertex = Parse(attrib, index);
         auto [it, inserted] = vertex_to_index.try_emplace(vertex, num_vertices);
         if (inserted)
         {
             vertex_data[num_vertices] = vertex;
-            index_data[model->vox_obj.num_indices++] = num_vertices++;
+            index_data[num_indices++] = num_vertices++;
         }
         else
         {
-            index_data[model->vox_obj.num_indices++] = it->second;
+            index_data[num_indices++] = it->second;
         }
     }
-    SDL_assert(std::fmod(model->max.x, 1.0f) == 0.0f);
-    SDL_assert(std::fmod(model->max.y, 1.0f) == 0.0f);
-    SDL_assert(std::fmod(model->max.z, 1.0f) == 0.0f);
-    SDL_UnmapGPUTransferBuffer(device, vertex_transfer_buffer);
-    SDL_UnmapGPUTransferBuffer(device, index_transfer_buffer);
+    /* truncation is monotonic so scaling the float bounds matches the quantized vertices */
+    SDLx_ModelVec3 min = data->min;
+    SDLx_ModelVec3 max = data->max;
+    ComputeBounds(attrib.vertices.data(), attrib.vertices.size() / 3, sizeof(SDLx_ModelVec3), min, max);
+    data->min = {float(int(min.x * PositionScale)), float(int(min.y * PositionScale)), float(int(min.z * PositionScale))};
+    data->max = {float(int(max.x * PositionScale)), float(int(max.y * PositionScale)), float(int(max.z * PositionScale))};
+    SDL_assert(std::fmod(data->max.x, 1.0f) == 0.0f);
+    SDL_assert(std::fmod(data->max.y, 1.0f) == 0.0f);
+    SDL_assert(std::fmod(data->max.z, 1.0f) == 0.0f);
+    if (!DecodeImage(path.replace_extension(".png"), data->vox_obj.palette))
+    {
+        SDL_Log("Failed to load texture: %s", path.string().data());
+        return false;
+    }
+    data->allocations.emplace_back(data->vox_obj.palette.pixels, FreeImage);
+    data->vox_obj.vertices = vertex_data;
+    data->vox_obj.indices = index_data;
+    data->vox_obj.num_vertices = num_vertices;
+    data->vox_obj.num_indices = num_indices;
+    data->vox_obj.index_element_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+    if (data->flags & SDLX_MODELFLAG_OPTIMIZE)
     {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-        info.size = num_vertices * sizeof(SDLx_ModelVoxObjVertex);
-        model->vox_obj.vertex_buffer = SDL_CreateGPUBuffer(device, &info);
-        info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-        info.size = model->vox_obj.num_indices * sizeof(uint16_t);
-        model->vox_obj.index_buffer = SDL_CreateGPUBuffer(device, &info);
-        if (!model->vox_obj.vertex_buffer || !model->vox_obj.index_buffer)
+        Optimize(data);
+    }
+    return true;
+}
+
+/*
+ * Greedy meshing, one task per slice of each of the six face directions. A
+ * slice masks the faces of its voxels whose neighbour along the direction is
+ * empty, then grows each face into the widest, then tallest, rectangle of the
+ * same palette index. Voxel space is z up and is rotated to the y up space of
+ * the obj exports, centered on the model size.
+ */
+
+using Quad = std::array<SDLx_ModelVoxObjVertex, 4>;
+
+/* every placed model in one z up voxel space grid, offset by origin */
+struct Grid
+{
+    int size[3];
+    int origin[3];
+    std::vector<uint8_t> voxels;
+
+    uint8_t Get(const int position[3]) const
+    {
+        for (int i = 0; i < 3; i++)
         {
-            SDL_Log("Failed to create buffer(s): %s, %s", path.string().data(), SDL_GetError());
+            if (position[i] < 0 || position[i] >= size[i])
+            {
+                return 0;
+            }
+        }
+        return voxels[position[0] + size[0] * (position[1] + size[1] * position[2])];
+    }
+
+    /* rotated from z up to y up like the vox raw instances */
+    void Transform(const int position[3], int dst_position[3]) const
+    {
+        dst_position[0] = position[0] + origin[0];
+        dst_position[1] = position[2] + origin[2];
+        dst_position[2] = -position[1] - origin[1];
+    }
+};
+
+/* rotates the voxel center around the model center so flipped axes stay on the grid */
+static void PlaceVoxel(const VoxNode& node, const VoxModel& model, const VoxVoxel& voxel, int position[3])
+{
+    int local[3] =
+    {
+        2 * (voxel.x - int(model.size_x / 2)) + 1,
+        2 * (voxel.y - int(model.size_y / 2)) + 1,
+        2 * (voxel.z - int(model.size_z / 2)) + 1,
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        int value = 2 * node.translation[i];
+        for (int j = 0; j < 3; j++)
+        {
+            value += node.rotation[i][j] * local[j];
+        }
+        position[i] = (value - 1) / 2;
+    }
+}
+
+/* obj normal of the face pointing along +/- each voxel axis */
+static constexpr uint64_t GreedyNormals[3][2] = {{0, 1}, {5, 4}, {2, 3}};
+
+static void MeshSlice(const Grid& grid, int axis, int direction, int slice, std::vector<Quad>& quads)
+{
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    int size_u = grid.size[u];
+    int size_v = grid.size[v];
+    std::vector<uint8_t> mask(size_u * size_v);
+    for (int j = 0; j < size_v; j++)
+    {
+        for (int i = 0; i < size_u; i++)
+        {
+            int position[3];
+            position[axis] = slice;
+            position[u] = i;
+            position[v] = j;
+            uint8_t palette_index = grid.Get(position);
+            position[axis] += direction ? 1 : -1;
+            mask[i + j * size_u] = grid.Get(position) ? 0 : palette_index;
+        }
+    }
+    uint64_t normal = GreedyNormals[axis][direction];
+    for (int j = 0; j < size_v; j++)
+    {
+        for (int i = 0; i < size_u;)
+        {
+            uint8_t palette_index = mask[i + j * size_u];
+            if (!palette_index)
+            {
+                i++;
+                continue;
+            }
+            int width = 1;
+            while (i + width < size_u && mask[i + width + j * size_u] == palette_index)
+            {
+                width++;
+            }
+            int height = 1;
+            for (; j + height < size_v; height++)
+            {
+                const uint8_t* row = &mask[i + (j + height) * size_u];
+                if (std::any_of(row, row + width, [palette_index](uint8_t other) { return other != palette_index; }))
+                {
+                    break;
+                }
+            }
+            for (int k = 0; k < height; k++)
+            {
+                std::fill_n(&mask[i + (j + k) * size_u], width, 0);
+            }
+            static constexpr int Corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+            int positions[4][3];
+            for (int k = 0; k < 4; k++)
+            {
+                int position[3];
+                position[axis] = slice + direction;
+                position[u] = i + Corners[k][0] * width;
+                position[v] = j + Corners[k][1] * height;
+                grid.Transform(position, positions[k]);
+            }
+            /* wind counter clockwise when viewed from the side the face points to */
+            int edge1[3];
+            int edge2[3];
+            for (int k = 0; k < 3; k++)
+            {
+                edge1[k] = positions[1][k] - positions[0][k];
+                edge2[k] = positions[2][k] - positions[0][k];
+            }
+            int cross[3] =
+            {
+                edge1[1] * edge2[2] - edge1[2] * edge2[1],
+                edge1[2] * edge2[0] - edge1[0] * edge2[2],
+                edge1[0] * edge2[1] - edge1[1] * edge2[0],
+            };
+            bool negative = cross[normal / 2] < 0;
+            bool flip = negative != (normal % 2 == 0);
+            Quad& quad = quads.emplace_back();
+            for (int k = 0; k < 4; k++)
+            {
+                const int* position = positions[flip ? (4 - k) % 4 : k];
+                quad[k] = Pack(position[0], position[1], position[2], normal, palette_index - 1);
+            }
+            i += width;
+        }
+    }
+}
+
+bool DecodeVoxGreedy(Data* data, std::filesystem::path& path)
+{
+    Vox vox;
+    if (!ParseVox(data, path, vox))
+    {
+        return false;
+    }
+    if (vox.models.empty())
+    {
+        SDL_Log("Failed to find vox model: %s", path.string().data());
+        return false;
+    }
+    for (const VoxModel& model : vox.models)
+    {
+        if (!model.size_x || !model.size_y || !model.size_z || model.size_x > 256 || model.size_y > 256 || model.size_z > 256)
+        {
+            SDL_Log("Invalid vox size: %s", path.string().data());
+            return false;
+        }
+    }
+    /* each node places its model with the node transform, later nodes win on overlap */
+    std::vector<const VoxNode*> nodes;
+    for (const VoxNode& node : vox.nodes)
+    {
+        if (node.model < 0 || node.model >= int(vox.models.size()))
+        {
+            SDL_Log("Invalid vox model reference: %s, %d", path.string().data(), node.model);
+            continue;
+        }
+        nodes.push_back(&node);
+    }
+    int min[3] = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    int max[3] = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+    for (const VoxNode* node : nodes)
+    {
+        const VoxModel& model = vox.models[node->model];
+        for (const VoxVoxel& voxel : model.voxels)
+        {
+            if (!voxel.palette_index || voxel.x >= model.size_x || voxel.y >= model.size_y || voxel.z >= model.size_z)
+            {
+                continue;
+            }
+            int position[3];
+            PlaceVoxel(*node, model, voxel, position);
+            for (int i = 0; i < 3; i++)
+            {
+                min[i] = std::min(min[i], position[i]);
+                max[i] = std::max(max[i], position[i] + 1);
+            }
+        }
+    }
+    if (min[0] >= max[0])
+    {
+        min[0] = min[1] = min[2] = 0;
+        max[0] = max[1] = max[2] = 0;
+    }
+    /* the packed vertices hold 8 bit magnitudes */
+    for (int i = 0; i < 3; i++)
+    {
+        if (min[i] < -255 || max[i] > 255)
+        {
+            SDL_Log("Vox scene exceeds the greedy mesh range of +/-255: %s", path.string().data());
             return false;
         }
     }
+    Grid grid;
+    for (int i = 0; i < 3; i++)
+    {
+        grid.size[i] = max[i] - min[i];
+        grid.origin[i] = min[i];
+    }
+    grid.voxels.resize(size_t(grid.size[0]) * grid.size[1] * grid.size[2]);
+    for (const VoxNode* node : nodes)
+    {
+        const VoxModel& model = vox.models[node->model];
+        for (const VoxVoxel& voxel : model.voxels)
+        {
+            if (!voxel.palette_index || voxel.x >= model.size_x || voxel.y >= model.size_y || voxel.z >= model.size_z)
+            {
+                continue;
+            }
+            int position[3];
+            PlaceVoxel(*node, model, voxel, position);
+            for (int i = 0; i < 3; i++)
+            {
+                position[i] -= grid.origin[i];
+            }
+            grid.voxels[position[0] + grid.size[0] * (position[1] + grid.size[1] * position[2])] = voxel.palette_index;
+        }
+    }
+    int num_slices = grid.size[0] + grid.size[1] + grid.size[2];
+    std::vector<std::vector<Quad>> slice_quads(num_slices * 2);
+    ParallelFor(slice_quads.size(), [&](size_t i)
+    {
+        int direction = i % 2;
+        int slice = i / 2;
+        int axis = 0;
+        for (; slice >= grid.size[axis]; axis++)
+        {
+            slice -= grid.size[axis];
+        }
+        MeshSlice(grid, axis, direction, slice, slice_quads[i]);
+    });
+    std::vector<SDLx_ModelVoxObjVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::unordered_map<SDLx_ModelVoxObjVertex, uint32_t> vertex_to_index;
+    for (const std::vector<Quad>& quads : slice_quads)
     {
-        SDL_GPUTransferBufferLocation location{};
-        SDL_GPUBufferRegion region{};
-        location.transfer_buffer = vertex_transfer_buffer;
-        region.buffer = model->vox_obj.vertex_buffer;
-        region.size = num_vertices * sizeof(SDLx_ModelVoxObjVertex);
-        SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-        location.transfer_buffer = index_transfer_buffer;
-        region.buffer = model->vox_obj.index_buffer;
-        region.size = model->vox_obj.num_indices * sizeof(uint16_t);
-        SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
+        for (const Quad& quad : quads)
+        {
+            uint32_t quad_indices[4];
+            for (int i = 0; i < 4; i++)
+            {
+                auto [it, inserted] = vertex_to_index.try_emplace(quad[i], vertices.size());
+                if (inserted)
+                {
+                    vertices.push_back(quad[i]);
+                }
+                quad_indices[i] = it->second;
+            }
+            indices.insert(indices.end(), {quad_indices[0], quad_indices[1], quad_indices[2]});
+            indices.insert(indices.end(), {quad_indices[0], quad_indices[2], quad_indices[3]});
+        }
     }
-    SDL_ReleaseGPUTransferBuffer(device, vertex_transfer_buffer);
-    SDL_ReleaseGPUTransferBuffer(device, index_transfer_buffer);
-    model->vox_obj.palette_texture = LoadTexture(device, copy_pass, path.replace_extension(".png"));
+    SDLx_ModelVoxObjVertex* vertex_data = data->Allocate<SDLx_ModelVoxObjVertex>(vertices.size());
+    uint32_t* palette_data = data->Allocate<uint32_t>(256);
+    void* index_data;
+    if (vertices.size() <= std::numeric_limits<uint16_t>::max())
+    {
+        uint16_t* index_data16 = data->Allocate<uint16_t>(indices.size());
+        if (index_data16)
+        {
+            std::copy(indices.begin(), indices.end(), index_data16);
+        }
+        index_data = index_data16;
+        data->vox_obj.index_element_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+    }
+    else
+    {
+        uint32_t* index_data32 = data->Allocate<uint32_t>(indices.size());
+        if (index_data32)
+        {
+            std::copy(indices.begin(), indices.end(), index_data32);
+        }
+        index_data = index_data32;
+        data->vox_obj.index_element_size = SDL_GPU_INDEXELEMENTSIZE_32BIT;
+    }
+    if (!vertex_data || !index_data || !palette_data)
+    {
+        SDL_Log("Failed to allocate vertices, indices and palette: %s", path.string().data());
+        return false;
+    }
+    std::copy(vertices.begin(), vertices.end(), vertex_data);
+    /* texel i holds palette index i + 1, like the png exports */
+    std::copy(vox.palette.begin() + 1, vox.palette.end(), palette_data);
+    palette_data[255] = 0;
+    int zero[3] = {0, 0, 0};
+    int dst_min[3];
+    int dst_max[3];
+    grid.Transform(zero, dst_min);
+    grid.Transform(grid.size, dst_max);
+    data->min = {float(dst_min[0]), float(dst_min[1]), float(std::min(dst_min[2], dst_max[2]))};
+    data->max = {float(dst_max[0]), float(dst_max[1]), float(std::max(dst_min[2], dst_max[2]))};
+    data->vox_obj.vertices = vertex_data;
+    data->vox_obj.indices = index_data;
+    data->vox_obj.num_vertices = vertices.size();
+    data->vox_obj.num_indices = indices.size();
+    data->vox_obj.palette.pixels = palette_data;
+    data->vox_obj.palette.width = 256;
+    data->vox_obj.palette.height = 1;
+    data->vox_obj.palette.num_levels = 1;
+    data->vox_obj.palette.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    if (data->flags & SDLX_MODELFLAG_OPTIMIZE)
+    {
+        Optimize(data);
+    }
+    return true;
+}
+
+bool UploadVoxObj(Model* model, Staging& staging, const SDLx_ModelData* data)
+{
+    const SDLx_ModelVoxObjData& src_vox_obj = data->vox_obj;
+    uint32_t vertex_size = src_vox_obj.num_vertices * sizeof(SDLx_ModelVoxObjVertex);
+    uint32_t index_size = src_vox_obj.num_indices * (src_vox_obj.index_element_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4);
+    model->vox_obj.vertex_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_VERTEX, src_vox_obj.vertices, vertex_size);
+    if (model->vox_obj.vertex_buffer)
+    {
+        model->buffers.push_back(model->vox_obj.vertex_buffer);
+    }
+    model->vox_obj.index_buffer = CreateBuffer(staging, SDL_GPU_BUFFERUSAGE_INDEX, src_vox_obj.indices, index_size);
+    if (model->vox_obj.index_buffer)
+    {
+        model->buffers.push_back(model->vox_obj.index_buffer);
+    }
+    if (!model->vox_obj.vertex_buffer || !model->vox_obj.index_buffer)
+    {
+        SDL_Log("Failed to create buffer(s)");
+        return false;
+    }
+    model->vox_obj.palette_texture = CreateTexture(staging, src_vox_obj.palette);
     if (!model->vox_obj.palette_texture)
     {
-        SDL_Log("Failed to load texture: %s", path.string().data());
+        SDL_Log("Failed to create texture");
         return false;
     }
-    model->vox_obj.index_element_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+    model->textures.push_back(model->vox_obj.palette_texture);
+    model->vox_obj.num_indices = src_vox_obj.num_indices;
+    model->vox_obj.index_element_size = src_vox_obj.index_element_size;
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,379 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "internal.hpp"
+
+/*
+ * Built bottom up from the Morton codes of the occupied bricks. Sorting the
+ * codes lays out every level in Morton order, so the children of a node are
+ * contiguous in the next level and a node only needs the index of the first.
+ */
+
+static constexpr int BrickShift = 2;
+static constexpr int BrickSize = 1 << BrickShift;
+
+static uint64_t Spread(uint64_t value)
+{
+    uint64_t result = 0;
+    for (int i = 0; i < 21; i++)
+    {
+        result |= ((value >> i) & 1) << (i * 3);
+    }
+    return result;
+}
+
+static uint64_t Encode(int x, int y, int z)
+{
+    return Spread(x) | Spread(y) << 1 | Spread(z) << 2;
+}
+
+static int GetChild(int x, int y, int z, int shift)
+{
+    return ((x >> shift) & 1) | ((y >> shift) & 1) << 1 | ((z >> shift) & 1) << 2;
+}
+
+static uint32_t GetChildIndex(const SDLx_ModelVoxOctreeNode& node, int child)
+{
+    return node.first_child + std::popcount<uint32_t>(node.child_mask & ((1u << child) - 1));
+}
+
+void BuildVoxOctree(const VoxModel& model, std::vector<SDLx_ModelVoxOctreeNode>& nodes, std::vector<SDLx_ModelVoxOctreeBrick>& bricks, int& depth)
+{
+    int size = std::max({model.size_x, model.size_y, model.size_z, 1u});
+    for (const VoxVoxel& voxel : model.voxels)
+    {
+        size = std::max({size, voxel.x + 1, voxel.y + 1, voxel.z + 1});
+    }
+    depth = 1;
+    while ((BrickSize << depth) < size)
+    {
+        depth++;
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> voxel_codes;
+    voxel_codes.reserve(model.voxels.size());
+    for (uint32_t i = 0; i < model.voxels.size(); i++)
+    {
+        const VoxVoxel& voxel = model.voxels[i];
+        if (voxel.palette_index)
+        {
+            voxel_codes.emplace_back(Encode(voxel.x >> BrickShift, voxel.y >> BrickShift, voxel.z >> BrickShift), i);
+        }
+    }
+    std::sort(voxel_codes.begin(), voxel_codes.end());
+    std::vector<std::vector<uint64_t>> levels(depth + 1);
+    bricks.clear();
+    for (const auto& [code, index] : voxel_codes)
+    {
+        if (levels[depth].empty() || levels[depth].back() != code)
+        {
+            levels[depth].push_back(code);
+            bricks.emplace_back();
+        }
+        const VoxVoxel& voxel = model.voxels[index];
+        int local = (voxel.x & 3) | (voxel.y & 3) << 2 | (voxel.z & 3) << 4;
+        bricks.back().mask |= uint64_t(1) << local;
+        bricks.back().palette_indices[local] = voxel.palette_index;
+    }
+    for (int level = depth - 1; level >= 0; level--)
+    {
+        for (uint64_t code : levels[level + 1])
+        {
+            if (levels[level].empty() || levels[level].back() != code >> 3)
+            {
+                levels[level].push_back(code >> 3);
+            }
+        }
+    }
+    /* the root always exists, even for an empty model */
+    if (levels[0].empty())
+    {
+        levels[0].push_back(0);
+    }
+    nodes.clear();
+    uint32_t level_offset = 0;
+    for (int level = 0; level < depth; level++)
+    {
+        uint32_t child_offset = level + 1 < depth ? level_offset + levels[level].size() : 0;
+        const std::vector<uint64_t>& children = levels[level + 1];
+        size_t child = 0;
+        for (uint64_t code : levels[level])
+        {
+            SDLx_ModelVoxOctreeNode& node = nodes.emplace_back();
+            node.first_child = child_offset + child;
+            for (; child < children.size() && children[child] >> 3 == code; child++)
+            {
+                node.child_mask |= 1u << (children[child] & 7);
+            }
+        }
+        level_offset += levels[level].size();
+    }
+}
+
+Uint8 SDLx_ModelGetVoxel(const SDLx_ModelVoxOctree* octree, int x, int y, int z)
+{
+    if (!octree)
+    {
+        SDL_InvalidParamError("octree");
+        return 0;
+    }
+    if (x < 0 || y < 0 || z < 0 || x >= octree->size || y >= octree->size || z >= octree->size || !octree->num_nodes)
+    {
+        return 0;
+    }
+    uint32_t index = 0;
+    for (int level = 0; level < octree->depth; level++)
+    {
+        const SDLx_ModelVoxOctreeNode& node = octree->nodes[index];
+        int child = GetChild(x, y, z, BrickShift + octree->depth - 1 - level);
+        if (!(node.child_mask & (1u << child)))
+        {
+            return 0;
+        }
+        index = GetChildIndex(node, child);
+    }
+    return octree->bricks[index].palette_indices[(x & 3) | (y & 3) << 2 | (z & 3) << 4];
+}
+
+struct Iterator
+{
+    const SDLx_ModelVoxOctree* octree;
+    int min[3];
+    int max[3];
+    SDLx_ModelVoxelCallback callback;
+    void* userdata;
+
+    bool Iterate(uint32_t index, int level, const int position[3])
+    {
+        int size = BrickSize << (octree->depth - level);
+        for (int i = 0; i < 3; i++)
+        {
+            if (position[i] >= max[i] || position[i] + size <= min[i])
+            {
+                return true;
+            }
+        }
+        if (level == octree->depth)
+        {
+            const SDLx_ModelVoxOctreeBrick& brick = octree->bricks[index];
+            for (uint64_t mask = brick.mask; mask; mask &= mask - 1)
+            {
+                int local = std::countr_zero(mask);
+                int x = position[0] + (local & 3);
+                int y = position[1] + ((local >> 2) & 3);
+                int z = position[2] + ((local >> 4) & 3);
+                if (x >= min[0] && y >= min[1] && z >= min[2] && x < max[0] && y < max[1] && z < max[2] &&
+                    !callback(userdata, x, y, z, brick.palette_indices[local]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        const SDLx_ModelVoxOctreeNode& node = octree->nodes[index];
+        int half = size / 2;
+        for (int child = 0; child < 8; child++)
+        {
+            if (!(node.child_mask & (1u << child)))
+            {
+                continue;
+            }
+            int child_position[3] =
+            {
+                position[0] + (child & 1) * half,
+                position[1] + ((child >> 1) & 1) * half,
+                position[2] + ((child >> 2) & 1) * half,
+            };
+            if (!Iterate(GetChildIndex(node, child), level + 1, child_position))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+bool SDLx_ModelIterateVoxels(const SDLx_ModelVoxOctree* octree, const int min[3], const int max[3], SDLx_ModelVoxelCallback callback, void* userdata)
+{
+    if (!octree)
+    {
+        SDL_InvalidParamError("octree");
+        return false;
+    }
+    if (!min || !max)
+    {
+        SDL_InvalidParamError(!min ? "min" : "max");
+        return false;
+    }
+    if (!callback)
+    {
+        SDL_InvalidParamError("callback");
+        return false;
+    }
+    if (!octree->num_nodes)
+    {
+        return true;
+    }
+    Iterator iterator{octree, {min[0], min[1], min[2]}, {max[0], max[1], max[2]}, callback, userdata};
+    static constexpr int Origin[3] = {0, 0, 0};
+    return iterator.Iterate(0, 0, Origin);
+}
+
+/*
+ * Children are visited front to back by their entry distance. Boxes that
+ * don't overlap are crossed in disjoint intervals, so the first hit found is
+ * the nearest.
+ */
+struct Raycaster
+{
+    const SDLx_ModelVoxOctree* octree;
+    float origin[3];
+    float direction[3];
+    float max_distance;
+    SDLx_ModelVoxelHit* hit;
+
+    /* slab test, returning the entry distance and the axis it was entered through */
+    bool Intersect(const int position[3], int size, float& distance, int& axis) const
+    {
+        float enter = 0.0f;
+        float exit = max_distance;
+        axis = -1;
+        for (int i = 0; i < 3; i++)
+        {
+            float min = position[i];
+            float max = position[i] + size;
+            if (direction[i] == 0.0f)
+            {
+                if (origin[i] < min || origin[i] >= max)
+                {
+                    return false;
+                }
+                continue;
+            }
+            float t1 = (min - origin[i]) / direction[i];
+            float t2 = (max - origin[i]) / direction[i];
+            if (t1 > t2)
+            {
+                std::swap(t1, t2);
+            }
+            if (t1 > enter)
+            {
+                enter = t1;
+                axis = i;
+            }
+            exit = std::min(exit, t2);
+            if (enter > exit)
+            {
+                return false;
+            }
+        }
+        distance = enter;
+        return true;
+    }
+
+    bool Raycast(uint32_t index, int level, const int position[3])
+    {
+        if (level == octree->depth)
+        {
+            const SDLx_ModelVoxOctreeBrick& brick = octree->bricks[index];
+            float nearest = std::numeric_limits<float>::max();
+            for (uint64_t mask = brick.mask; mask; mask &= mask - 1)
+            {
+                int local = std::countr_zero(mask);
+                int voxel[3] = {position[0] + (local & 3), position[1] + ((local >> 2) & 3), position[2] + ((local >> 4) & 3)};
+                float distance;
+                int axis;
+                if (!Intersect(voxel, 1, distance, axis) || distance >= nearest)
+                {
+                    continue;
+                }
+                nearest = distance;
+                hit->x = voxel[0];
+                hit->y = voxel[1];
+                hit->z = voxel[2];
+                hit->palette_index = brick.palette_indices[local];
+                hit->distance = distance;
+                float normal[3] = {};
+                if (axis >= 0)
+                {
+                    normal[axis] = direction[axis] > 0.0f ? -1.0f : 1.0f;
+                }
+                hit->normal = {normal[0], normal[1], normal[2]};
+            }
+            return nearest != std::numeric_limits<float>::max();
+        }
+        const SDLx_ModelVoxOctreeNode& node = octree->nodes[index];
+        int half = (BrickSize << (octree->depth - level)) / 2;
+        std::pair<float, int> children[8];
+        int num_children = 0;
+        for (int child = 0; child < 8; child++)
+        {
+            if (!(node.child_mask & (1u << child)))
+            {
+                continue;
+            }
+            int child_position[3] =
+            {
+                position[0] + (child & 1) * half,
+                position[1] + ((child >> 1) & 1) * half,
+                position[2] + ((child >> 2) & 1) * half,
+            };
+            float distance;
+            int axis;
+            if (Intersect(child_position, half, distance, axis))
+            {
+                children[num_children++] = {distance, child};
+            }
+        }
+        std::sort(children, children + num_children);
+        for (int i = 0; i < num_children; i++)
+        {
+            int child = children[i].second;
+            int child_position[3] =
+            {
+                position[0] + (child & 1) * half,
+                position[1] + ((child >> 1) & 1) * half,
+                position[2] + ((child >> 2) & 1) * half,
+            };
+            if (Raycast(GetChildIndex(node, child), level + 1, child_position))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+bool SDLx_ModelRaycastVoxels(const SDLx_ModelVoxOctree* octree, SDLx_ModelVec3 origin, SDLx_ModelVec3 direction, float max_distance, SDLx_ModelVoxelHit* hit)
+{
+    if (!octree)
+    {
+        SDL_InvalidParamError("octree");
+        return false;
+    }
+    if (!hit)
+    {
+        SDL_InvalidParamError("hit");
+        return false;
+    }
+    if (!octree->num_nodes)
+    {
+        return false;
+    }
+    Raycaster raycaster{octree, {origin.x, origin.y, origin.z}, {direction.x, direction.y, direction.z}, max_distance, hit};
+    static constexpr int Origin[3] = {0, 0, 0};
+    float distance;
+    int axis;
+    if (!raycaster.Intersect(Origin, octree->size, distance, axis))
+    {
+        return false;
+    }
+    return raycaster.Raycast(0, 0, Origin);
+}
@@ -1,149 +1,532 @@
 #include <SDL3/SDL.h>
 #include <SDLx_model/SDL_model.h>
 
-#include <cmath>
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "internal.hpp"
 
 template<typename T>
-T Read(std::ifstream& file)
+static T Read(std::span<const uint8_t>& span)
 {
 #if SDL_BYTEORDER != SDL_LIL_ENDIAN
 #error "Big endian currently unsupported"
 #endif
-    T data;
-    file.read(reinterpret_cast<char*>(&data), sizeof(data));
+    T data{};
+    if (span.size() < sizeof(data))
+    {
+        span = {};
+        return data;
+    }
+    std::memcpy(&data, span.data(), sizeof(data));
+    span = span.subspan(sizeof(data));
     return data;
 }
 
-bool LoadVoxRaw(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, std::filesystem::path& path)
+static std::string ReadString(std::span<const uint8_t>& span)
 {
-    std::ifstream file(path.replace_extension(".vox"), std::ios::binary);
-    if (!file)
+    uint32_t size = Read<uint32_t>(span);
+    if (size > span.size())
     {
-        SDL_Log("Failed to open vox: %s", path.string().data());
-        return false;
+        span = {};
+        return {};
     }
-    char magic[4];
-    file.read(magic, 4);
-    if (std::strncmp(magic, "VOX ", 4))
+    std::string string(reinterpret_cast<const char*>(span.data()), size);
+    span = span.subspan(size);
+    return string;
+}
+
+static std::unordered_map<std::string, std::string> ReadDict(std::span<const uint8_t>& span)
+{
+    std::unordered_map<std::string, std::string> dict;
+    uint32_t num_pairs = Read<uint32_t>(span);
+    for (uint32_t i = 0; i < num_pairs && !span.empty(); i++)
+    {
+        std::string key = ReadString(span);
+        dict[key] = ReadString(span);
+    }
+    return dict;
+}
+
+/*
+ * nTRN nodes have one child and a transform, nGRP nodes any number of
+ * children and nSHP nodes reference models. Only the first frame of an
+ * animated transform is used.
+ */
+struct VoxSceneNode
+{
+    char type;
+    bool hidden;
+    std::vector<int> children;
+    VoxNode transform;
+};
+
+static VoxNode GetIdentity()
+{
+    VoxNode node{};
+    for (int i = 0; i < 3; i++)
+    {
+        node.rotation[i][i] = 1;
+    }
+    return node;
+}
+
+static void ParseTransform(const std::unordered_map<std::string, std::string>& frame, VoxNode& node)
+{
+    node = GetIdentity();
+    if (auto it = frame.find("_r"); it != frame.end())
+    {
+        /* bits 0-1 and 2-3 are the columns of the first two rows, bits 4-6 the row signs */
+        int bits = std::atoi(it->second.data());
+        int column0 = (bits >> 0) & 3;
+        int column1 = (bits >> 2) & 3;
+        if (column0 < 3 && column1 < 3 && column0 != column1)
+        {
+            int columns[3] = {column0, column1, 3 - column0 - column1};
+            for (int i = 0; i < 3; i++)
+            {
+                node.rotation[i][i] = 0;
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                node.rotation[i][columns[i]] = (bits >> (4 + i)) & 1 ? -1 : 1;
+            }
+        }
+    }
+    if (auto it = frame.find("_t"); it != frame.end())
+    {
+        std::sscanf(it->second.data(), "%d %d %d", &node.translation[0], &node.translation[1], &node.translation[2]);
+    }
+}
+
+static void Flatten(const std::unordered_map<int, VoxSceneNode>& scene, int id, const VoxNode& parent, int depth, Vox& vox)
+{
+    auto it = scene.find(id);
+    if (it == scene.end() || depth > 64)
+    {
+        return;
+    }
+    const VoxSceneNode& scene_node = it->second;
+    if (scene_node.hidden)
+    {
+        return;
+    }
+    switch (scene_node.type)
+    {
+    case 'T':
+    {
+        const VoxNode& local = scene_node.transform;
+        VoxNode node{};
+        for (int i = 0; i < 3; i++)
+        {
+            node.translation[i] = parent.translation[i];
+            for (int j = 0; j < 3; j++)
+            {
+                node.translation[i] += parent.rotation[i][j] * local.translation[j];
+                for (int k = 0; k < 3; k++)
+                {
+                    node.rotation[i][j] += parent.rotation[i][k] * local.rotation[k][j];
+                }
+            }
+        }
+        for (int child : scene_node.children)
+        {
+            Flatten(scene, child, node, depth + 1, vox);
+        }
+        break;
+    }
+    case 'G':
+        for (int child : scene_node.children)
+        {
+            Flatten(scene, child, parent, depth + 1, vox);
+        }
+        break;
+    case 'S':
+        for (int model : scene_node.children)
+        {
+            VoxNode& node = vox.nodes.emplace_back(parent);
+            node.model = model;
+        }
+        break;
+    }
+}
+
+bool ParseVox(Data* data, std::filesystem::path& path, Vox& vox)
+{
+    std::span<const uint8_t> file = MapFile(data, path.replace_extension(".vox"));
+    if (file.size() < 8 || std::memcmp(file.data(), "VOX ", 4))
     {
         SDL_Log("Failed to parse vox: %s", path.string().data());
         return false;
     }
+    file = file.subspan(4);
     uint32_t version = Read<uint32_t>(file);
-    struct Voxel
-    {
-        uint8_t x;
-        uint8_t y;
-        uint8_t z;
-        uint8_t palette_index;
-    };
-    std::vector<Voxel> voxels;
-    std::vector<uint32_t> palette;
-    while (file.good())
+    vox = {};
+    vox.palette.resize(256);
+    std::unordered_map<int, VoxSceneNode> scene;
+    VoxModel model{};
+    while (file.size() >= 12)
     {
-        char chunk_id[4];
-        file.read(chunk_id, 4);
+        const uint8_t* chunk_id = file.data();
+        file = file.subspan(4);
         uint32_t chunk_size = Read<uint32_t>(file);
         uint32_t child_chunk_size = Read<uint32_t>(file);
-        if (!std::strncmp(chunk_id, "XYZI", 4))
+        std::span<const uint8_t> chunk = file.first(std::min<size_t>(chunk_size, file.size()));
+        file = file.subspan(chunk.size());
+        if (!std::memcmp(chunk_id, "SIZE", 4))
+        {
+            model.size_x = Read<uint32_t>(chunk);
+            model.size_y = Read<uint32_t>(chunk);
+            model.size_z = Read<uint32_t>(chunk);
+        }
+        else if (!std::memcmp(chunk_id, "XYZI", 4))
+        {
+            /* every model is a SIZE chunk followed by an XYZI chunk */
+            uint32_t num_voxels = Read<uint32_t>(chunk);
+            num_voxels = std::min<size_t>(num_voxels, chunk.size() / sizeof(VoxVoxel));
+            model.voxels = {reinterpret_cast<const VoxVoxel*>(chunk.data()), num_voxels};
+            vox.models.push_back(model);
+            model = {};
+        }
+        else if (!std::memcmp(chunk_id, "RGBA", 4))
         {
-            voxels.resize(Read<uint32_t>(file));
-            for (uint32_t i = 0; i < voxels.size(); i++)
+            /* color i of the chunk is palette index i + 1 */
+            for (int i = 0; i < 255; i++)
             {
-                voxels[i] = Read<Voxel>(file);
+                vox.palette[i + 1] = Read<uint32_t>(chunk);
             }
         }
-        else if (!std::strncmp(chunk_id, "RGBA", 4))
+        else if (!std::memcmp(chunk_id, "nTRN", 4))
         {
-            palette.resize(256);
-            for (int i = 0; i < 254; i++)
+            int id = Read<int32_t>(chunk);
+            VoxSceneNode& scene_node = scene[id];
+            scene_node.type = 'T';
+            scene_node.hidden = ReadDict(chunk)["_hidden"] == "1";
+            scene_node.children.push_back(Read<int32_t>(chunk));
+            Read<int32_t>(chunk); /* reserved */
+            Read<int32_t>(chunk); /* layer */
+            uint32_t num_frames = Read<uint32_t>(chunk);
+            scene_node.transform = GetIdentity();
+            if (num_frames)
             {
-                palette[i + 1] = Read<uint32_t>(file);
+                ParseTransform(ReadDict(chunk), scene_node.transform);
             }
         }
-        else
+        else if (!std::memcmp(chunk_id, "nGRP", 4) || !std::memcmp(chunk_id, "nSHP", 4))
+        {
+            int id = Read<int32_t>(chunk);
+            VoxSceneNode& scene_node = scene[id];
+            scene_node.type = chunk_id[1] == 'G' ? 'G' : 'S';
+            ReadDict(chunk);
+            uint32_t num_children = Read<uint32_t>(chunk);
+            for (uint32_t i = 0; i < num_children && !chunk.empty(); i++)
+            {
+                scene_node.children.push_back(Read<int32_t>(chunk));
+                if (scene_node.type == 'S')
+                {
+                    ReadDict(chunk);
+                }
+            }
+        }
+    }
+    if (!scene.empty())
+    {
+        Flatten(scene, 0, GetIdentity(), 0, vox);
+    }
+    else
+    {
+        for (int i = 0; i < int(vox.models.size()); i++)
+        {
+            VoxNode& node = vox.nodes.emplace_back(GetIdentity());
+            node.model = i;
+        }
+    }
+    return true;
+}
+
+static uint32_t AddInstances(const VoxModel& model, const std::vector<uint32_t>& palette, bool cull, SDLx_ModelVoxRawInstance* instances)
+{
+    std::span<const VoxVoxel> voxels = model.voxels;
+    std::vector<bool> occupancy;
+    int size_x = 0;
+    int size_y = 0;
+    int size_z = 0;
+    if (cull)
+    {
+        for (const VoxVoxel& voxel : voxels)
+        {
+            size_x = std::max(size_x, voxel.x + 1);
+            size_y = std::max(size_y, voxel.y + 1);
+            size_z = std::max(size_z, voxel.z + 1);
+        }
+        occupancy.resize(size_x * size_y * size_z);
+        for (const VoxVoxel& voxel : voxels)
         {
-            file.seekg(chunk_size, std::ios::cur);
+            occupancy[voxel.x + size_x * (voxel.y + size_y * voxel.z)] = true;
         }
     }
-    SDL_GPUTransferBuffer* transfer_buffer;
+    /* a voxel is hidden when all six neighbours are inside the model and filled */
+    auto IsHidden = [&](const VoxVoxel& voxel)
     {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = voxels.size() * sizeof(SDLx_ModelVoxRawInstance);
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
+        if (occupancy.empty() || !voxel.x || !voxel.y || !voxel.z ||
+            voxel.x + 1 >= size_x || voxel.y + 1 >= size_y || voxel.z + 1 >= size_z)
         {
-            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
             return false;
         }
+        size_t index = voxel.x + size_x * (voxel.y + size_y * voxel.z);
+        size_t stride_y = size_x;
+        size_t stride_z = size_x * size_y;
+        return occupancy[index - 1] && occupancy[index + 1] &&
+               occupancy[index - stride_y] && occupancy[index + stride_y] &&
+               occupancy[index - stride_z] && occupancy[index + stride_z];
+    };
+    /* centered on size / 2 like MagicaVoxel and rotated from z up to y up */
+    int center_x = model.size_x / 2;
+    int center_y = model.size_y / 2;
+    int center_z = model.size_z / 2;
+    uint32_t num_instances = 0;
+    for (const VoxVoxel& voxel : voxels)
+    {
+        SDL_assert(voxel.palette_index < palette.size());
+        if (IsHidden(voxel))
+        {
+            continue;
+        }
+        SDLx_ModelVoxRawInstance instance;
+        instance.position.x = voxel.x - center_x;
+        instance.position.y = voxel.z - center_z;
+        instance.position.z = center_y - voxel.y - 1;
+        instance.color = SDL_Swap32(palette[voxel.palette_index]);
+        instances[num_instances++] = instance;
     }
+    return num_instances;
+}
+
+/* built from every voxel, including the ones dropped by SDLX_MODELFLAG_CULL */
+static bool BuildOctrees(Data* data, const Vox& vox)
+{
+    std::vector<std::vector<SDLx_ModelVoxOctreeNode>> nodes(vox.models.size());
+    std::vector<std::vector<SDLx_ModelVoxOctreeBrick>> bricks(vox.models.size());
+    data->vox_octrees.resize(vox.models.size());
+    ParallelFor(vox.models.size(), [&](size_t i)
     {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
-        info.size = voxels.size() * sizeof(SDLx_ModelVoxRawInstance);
-        model->vox_raw.instance_buffer = SDL_CreateGPUBuffer(device, &info);
-        if (!model->vox_raw.instance_buffer)
+        BuildVoxOctree(vox.models[i], nodes[i], bricks[i], data->vox_octrees[i].depth);
+    });
+    for (size_t i = 0; i < vox.models.size(); i++)
+    {
+        SDLx_ModelVoxOctree& octree = data->vox_octrees[i];
+        octree.nodes = data->Allocate<SDLx_ModelVoxOctreeNode>(nodes[i].size());
+        octree.bricks = data->Allocate<SDLx_ModelVoxOctreeBrick>(std::max<size_t>(bricks[i].size(), 1));
+        if (!octree.nodes || !octree.bricks)
         {
-            SDL_Log("Failed to create buffer: %s", SDL_GetError());
             return false;
         }
+        std::copy(nodes[i].begin(), nodes[i].end(), octree.nodes);
+        std::copy(bricks[i].begin(), bricks[i].end(), octree.bricks);
+        octree.num_nodes = nodes[i].size();
+        octree.num_bricks = bricks[i].size();
+        octree.size = 4 << octree.depth;
     }
-    SDLx_ModelVoxRawInstance* instance_data = static_cast<SDLx_ModelVoxRawInstance*>(SDL_MapGPUTransferBuffer(device, transfer_buffer, false));
+    data->vox_raw.octrees = data->vox_octrees.data();
+    return true;
+}
+
+/* conjugates a z up voxel space transform into the y up space of the instances */
+static void GetTransform(const VoxNode& node, SDLx_ModelMatrix transform)
+{
+    static constexpr int Axes[3][3] = {{1, 0, 0}, {0, 0, 1}, {0, -1, 0}};
+    std::fill_n(transform, 16, 0.0f);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            int value = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                for (int l = 0; l < 3; l++)
+                {
+                    value += Axes[i][k] * node.rotation[k][l] * Axes[j][l];
+                }
+            }
+            transform[j * 4 + i] = value;
+            transform[12 + i] += Axes[i][j] * node.translation[j];
+        }
+    }
+    transform[15] = 1.0f;
+}
+
+bool DecodeVoxRaw(Data* data, std::filesystem::path& path)
+{
+    Vox vox;
+    if (!ParseVox(data, path, vox))
+    {
+        return false;
+    }
+    size_t max_num_instances = 0;
+    for (const VoxModel& model : vox.models)
+    {
+        max_num_instances += model.voxels.size();
+    }
+    SDLx_ModelVoxRawInstance* instance_data = data->Allocate<SDLx_ModelVoxRawInstance>(std::max<size_t>(max_num_instances, 1));
     if (!instance_data)
     {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        SDL_Log("Failed to allocate instances: %s", path.string().data());
         return false;
     }
-    for (uint32_t i = 0; i < voxels.size(); i++)
+    /* each model is stored once and drawn per node with the node transform */
+    uint32_t num_instances = 0;
+    std::vector<SDLx_ModelVec3> shape_mins(vox.models.size());
+    std::vector<SDLx_ModelVec3> shape_maxs(vox.models.size());
+    data->vox_shapes.resize(vox.models.size());
+    for (size_t i = 0; i < vox.models.size(); i++)
     {
-        model->max.x = std::max(float(voxels[i].x + 1.0f), model->max.x);
-        model->max.y = std::max(float(voxels[i].z + 1.0f), model->max.y);
-        model->max.z = std::max(float(voxels[i].y + 1.0f), model->max.z);
+        SDLx_ModelVoxRawShape& shape = data->vox_shapes[i];
+        shape.first_instance = num_instances;
+        shape.num_instances = AddInstances(vox.models[i], vox.palette, data->flags & SDLX_MODELFLAG_CULL, instance_data + num_instances);
+        num_instances += shape.num_instances;
+        /* hidden voxels are interior so the bounds don't change */
+        shape_mins[i] = data->min;
+        shape_maxs[i] = data->max;
+        ComputeBounds(instance_data + shape.first_instance, shape.num_instances, sizeof(SDLx_ModelVoxRawInstance), shape_mins[i], shape_maxs[i]);
+        shape_maxs[i].x += 1.0f;
+        shape_maxs[i].y += 1.0f;
+        shape_maxs[i].z += 1.0f;
     }
-    SDL_assert(std::fmod(model->max.x, 2.0f) == 0.0f);
-    SDL_assert(std::fmod(model->max.y, 2.0f) == 0.0f);
-    SDL_assert(std::fmod(model->max.z, 2.0f) == 0.0f);
-    float center_x = model->max.x * 0.5f;
-    float center_y = model->max.y * 0.5f;
-    float center_z = model->max.z * 0.5f;
-    for (uint32_t i = 0; i < voxels.size(); i++)
+    if ((data->flags & SDLX_MODELFLAG_OCTREE) && !BuildOctrees(data, vox))
     {
-        SDL_assert(voxels[i].palette_index < palette.size());
-        SDLx_ModelVoxRawInstance instance;
-        instance.position.x = voxels[i].x - center_x;
-        instance.position.y = voxels[i].z - center_y;
-        instance.position.z = model->max.z - voxels[i].y - center_z - 1.0f;
-        instance.color = SDL_Swap32(palette[voxels[i].palette_index]);
-        instance_data[i] = instance;
-    }
-    SDL_GPUTransferBufferLocation location{};
-    SDL_GPUBufferRegion region{};
-    location.transfer_buffer = transfer_buffer;
-    region.buffer = model->vox_raw.instance_buffer;
-    region.size = voxels.size() * sizeof(SDLx_ModelVoxRawInstance);
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
-    model->vox_raw.vertex_buffer = CreateCubeVertexBuffer(device, copy_pass);
-    model->vox_raw.index_buffer = CreateCubeIndexBuffer(device, copy_pass);
+        SDL_Log("Failed to build octrees: %s", path.string().data());
+        return false;
+    }
+    SDLx_ModelVec3 min = data->min;
+    SDLx_ModelVec3 max = data->max;
+    for (const VoxNode& node : vox.nodes)
+    {
+        if (node.model < 0 || node.model >= int(vox.models.size()))
+        {
+            SDL_Log("Invalid vox model reference: %s, %d", path.string().data(), node.model);
+            continue;
+        }
+        SDLx_ModelVoxRawNodeData& node_data = data->vox_nodes.emplace_back();
+        node_data.shape = node.model;
+        GetTransform(node, node_data.transform);
+        if (!data->vox_shapes[node.model].num_instances)
+        {
+            continue;
+        }
+        const SDLx_ModelVec3& shape_min = shape_mins[node.model];
+        const SDLx_ModelVec3& shape_max = shape_maxs[node.model];
+        for (int i = 0; i < 8; i++)
+        {
+            float corner[3] =
+            {
+                i & 1 ? shape_max.x : shape_min.x,
+                i & 2 ? shape_max.y : shape_min.y,
+                i & 4 ? shape_max.z : shape_min.z,
+            };
+            float position[3];
+            for (int j = 0; j < 3; j++)
+            {
+                const float* transform = node_data.transform;
+                position[j] = transform[j] * corner[0] + transform[4 + j] * corner[1] + transform[8 + j] * corner[2] + transform[12 + j];
+            }
+            min = {std::min(min.x, position[0]), std::min(min.y, position[1]), std::min(min.z, position[2])};
+            max = {std::max(max.x, position[0]), std::max(max.y, position[1]), std::max(max.z, position[2])};
+        }
+    }
+    if (min.x > max.x)
+    {
+        min = {};
+        max = {};
+    }
+    data->vox_raw.instances = instance_data;
+    data->vox_raw.num_instances = num_instances;
+    data->vox_raw.shapes = data->vox_shapes.data();
+    data->vox_raw.num_shapes = data->vox_shapes.size();
+    data->vox_raw.nodes = data->vox_nodes.data();
+    data->vox_raw.num_nodes = data->vox_nodes.size();
+    data->min = min;
+    data->max = max;
+    return true;
+}
+
+bool UploadVoxRaw(Model* model, Staging& staging, const SDLx_ModelData* data)
+{
+    const SDLx_ModelVoxRawData& src_vox_raw = data->vox_raw;
+    {
+        SDL_GPUBufferUsageFlags usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+        uint32_t size = src_vox_raw.num_instances * sizeof(SDLx_ModelVoxRawInstance);
+        model->vox_raw.instance_buffer = CreateBuffer(staging, usage, src_vox_raw.instances, size);
+        if (!model->vox_raw.instance_buffer)
+        {
+            SDL_Log("Failed to create instance buffer");
+            return false;
+        }
+        model->buffers.push_back(model->vox_raw.instance_buffer);
+    }
+    model->vox_raw.vertex_buffer = AcquireCubeVertexBuffer(model, staging);
+    model->vox_raw.index_buffer = AcquireCubeIndexBuffer(model, staging);
     if (!model->vox_raw.vertex_buffer || !model->vox_raw.index_buffer)
     {
         SDL_Log("Failed to create buffer(s)");
         return false;
     }
+    model->vox_shapes.assign(src_vox_raw.shapes, src_vox_raw.shapes + src_vox_raw.num_shapes);
+    for (const SDLx_ModelVoxRawShape& shape : model->vox_shapes)
+    {
+        if (shape.first_instance > src_vox_raw.num_instances || shape.num_instances > src_vox_raw.num_instances - shape.first_instance)
+        {
+            SDL_Log("Invalid shape instances: %u, %u", shape.first_instance, shape.num_instances);
+            return false;
+        }
+    }
+    for (int i = 0; i < src_vox_raw.num_nodes; i++)
+    {
+        const SDLx_ModelVoxRawNodeData& src_node = src_vox_raw.nodes[i];
+        if (src_node.shape < 0 || src_node.shape >= src_vox_raw.num_shapes)
+        {
+            SDL_Log("Invalid node shape: %d", src_node.shape);
+            return false;
+        }
+        SDLx_ModelVoxRawNode& node = model->vox_nodes.emplace_back();
+        node.shape = &model->vox_shapes[src_node.shape];
+        std::copy_n(src_node.transform, 16, node.transform);
+    }
+    if (src_vox_raw.octrees)
+    {
+        size_t num_nodes = 0;
+        size_t num_bricks = 0;
+        for (int i = 0; i < src_vox_raw.num_shapes; i++)
+        {
+            num_nodes += src_vox_raw.octrees[i].num_nodes;
+            num_bricks += src_vox_raw.octrees[i].num_bricks;
+        }
+        model->vox_octree_nodes.reserve(num_nodes);
+        model->vox_octree_bricks.reserve(num_bricks);
+        for (int i = 0; i < src_vox_raw.num_shapes; i++)
+        {
+            const SDLx_ModelVoxOctree& src_octree = src_vox_raw.octrees[i];
+            SDLx_ModelVoxOctree& octree = model->vox_octrees.emplace_back(src_octree);
+            octree.nodes = model->vox_octree_nodes.data() + model->vox_octree_nodes.size();
+            octree.bricks = model->vox_octree_bricks.data() + model->vox_octree_bricks.size();
+            model->vox_octree_nodes.insert(model->vox_octree_nodes.end(), src_octree.nodes, src_octree.nodes + src_octree.num_nodes);
+            model->vox_octree_bricks.insert(model->vox_octree_bricks.end(), src_octree.bricks, src_octree.bricks + src_octree.num_bricks);
+        }
+        model->vox_raw.octrees = model->vox_octrees.data();
+    }
     model->vox_raw.num_indices = 36;
-    model->vox_raw.num_instances = voxels.size();
+    model->vox_raw.num_instances = src_vox_raw.num_instances;
+    model->vox_raw.shapes = model->vox_shapes.data();
+    model->vox_raw.num_shapes = model->vox_shapes.size();
+    model->vox_raw.nodes = model->vox_nodes.data();
+    model->vox_raw.num_nodes = model->vox_nodes.size();
     model->vox_raw.index_element_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
-    model->min = {-center_x, -center_y, -center_z};
-    model->max = { center_x,  center_y,  center_z};
     return true;
 }
\ No newline at end of file
@@ -1,190 +1,771 @@
 #include <SDL3/SDL.h>
 #include <SDLx_model/SDL_model.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "internal.hpp"
 #include "stb_image.h"
 
-SDL_GPUTexture* LoadTexture(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const std::filesystem::path& path)
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SDLX_MODEL_SSE 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SDLX_MODEL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SDLX_MODEL_TARGET_AVX2
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SDLX_MODEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+Data::~Data()
+{
+    for (SDL_GPUTexture* texture : image_textures)
+    {
+        if (texture)
+        {
+            ReleaseSharedTexture(device, texture);
+        }
+    }
+    for (std::span<const uint8_t> mapping : mappings)
+    {
+        UnmapFile(mapping);
+    }
+}
+
+std::span<const uint8_t> MapFile(Data* data, const std::filesystem::path& path)
+{
+    /* mapped copy-on-write so parsers that patch their input never touch the file */
+    void* mapping = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return {};
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+    {
+        HANDLE file_mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (file_mapping)
+        {
+            mapping = MapViewOfFile(file_mapping, FILE_MAP_COPY, 0, 0, 0);
+            size = file_size.QuadPart;
+            CloseHandle(file_mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        return {};
+    }
+    struct stat file_stat;
+    if (!fstat(file, &file_stat) && file_stat.st_size > 0)
+    {
+        size = file_stat.st_size;
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = nullptr;
+        }
+        else
+        {
+            madvise(mapping, size, MADV_WILLNEED);
+        }
+    }
+    close(file);
+#endif
+    if (!mapping)
+    {
+        SDL_Log("Failed to map file: %s", path.string().data());
+        return {};
+    }
+    std::span<const uint8_t> span(static_cast<const uint8_t*>(mapping), size);
+    data->mappings.push_back(span);
+    return span;
+}
+
+void UnmapFile(std::span<const uint8_t> file)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(file.data());
+#else
+    munmap(const_cast<uint8_t*>(file.data()), file.size());
+#endif
+}
+
+bool DecodeImage(const std::filesystem::path& path, SDLx_ModelImage& image)
 {
-    int width;
-    int height;
     int channels;
     stbi_set_flip_vertically_on_load_thread(true);
-    void* src_data = stbi_load(path.string().data(), &width, &height, &channels, 4);
-    if (!src_data)
+    image.pixels = stbi_load(path.string().data(), &image.width, &image.height, &channels, 4);
+    if (!image.pixels)
     {
         SDL_Log("Failed to load image: %s, %s", path.string().data(), stbi_failure_reason());
-        return nullptr;
+        return false;
+    }
+    image.num_levels = 1;
+    image.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    return true;
+}
+
+bool DecodeImage(std::span<const uint8_t> file, SDLx_ModelImage& image)
+{
+    int channels;
+    stbi_set_flip_vertically_on_load_thread(true);
+    image.pixels = stbi_load_from_memory(file.data(), file.size(), &image.width, &image.height, &channels, 4);
+    if (!image.pixels)
+    {
+        SDL_Log("Failed to load image: %s", stbi_failure_reason());
+        return false;
+    }
+    image.num_levels = 1;
+    image.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    return true;
+}
+
+bool GenerateMipmaps(SDLx_ModelImage& image)
+{
+    int num_levels = 1;
+    size_t size = image.width * image.height * 4;
+    for (int width = image.width, height = image.height; width > 1 || height > 1; num_levels++)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        size += width * height * 4;
+    }
+    if (num_levels == 1)
+    {
+        return true;
+    }
+    uint8_t* pixels = static_cast<uint8_t*>(SDL_malloc(size));
+    if (!pixels)
+    {
+        SDL_Log("Failed to allocate mipmaps");
+        return false;
+    }
+    std::memcpy(pixels, image.pixels, image.width * image.height * 4);
+    const uint8_t* src_data = pixels;
+    uint8_t* dst_data = pixels + image.width * image.height * 4;
+    int src_width = image.width;
+    int src_height = image.height;
+    for (int level = 1; level < num_levels; level++)
+    {
+        int dst_width = std::max(src_width / 2, 1);
+        int dst_height = std::max(src_height / 2, 1);
+        for (int y = 0; y < dst_height; y++)
+        {
+            /* odd edges clamp, so the last texel of a 3 wide row is counted twice */
+            const uint8_t* row0 = src_data + std::min(y * 2 + 0, src_height - 1) * src_width * 4;
+            const uint8_t* row1 = src_data + std::min(y * 2 + 1, src_height - 1) * src_width * 4;
+            for (int x = 0; x < dst_width; x++)
+            {
+                int x0 = std::min(x * 2 + 0, src_width - 1) * 4;
+                int x1 = std::min(x * 2 + 1, src_width - 1) * 4;
+                for (int c = 0; c < 4; c++)
+                {
+                    *dst_data++ = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+                }
+            }
+        }
+        src_data += src_width * src_height * 4;
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+    FreeImage(image.pixels);
+    image.pixels = pixels;
+    image.num_levels = num_levels;
+    return true;
+}
+
+uint64_t Hash(std::span<const uint8_t> bytes)
+{
+    /* not cryptographic, one multiply per 8 bytes for multi-megabyte inputs */
+    static constexpr uint64_t Prime = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = bytes.size() * Prime;
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, 8);
+        hash = (hash ^ word) * Prime;
+        hash ^= hash >> 32;
+    }
+    for (; i < bytes.size(); i++)
+    {
+        hash = (hash ^ bytes[i]) * Prime;
+    }
+    return hash ^ (hash >> 29);
+}
+
+uint64_t Hash(uint64_t hash, std::span<const uint8_t> bytes)
+{
+    return (hash ^ Hash(bytes)) * 0x9E3779B97F4A7C15ull;
+}
+
+void FreeImage(void* pixels)
+{
+    stbi_image_free(pixels);
+}
+
+void ParallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+    size_t num_threads = std::min<size_t>(count, std::max(SDL_GetNumLogicalCPUCores(), 1));
+    std::atomic<size_t> next = 0;
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            function(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/*
+ * Tightly packed positions are consumed in blocks of N vertices loaded as three
+ * registers of N floats. Lane i of register r always holds component
+ * (r * N + i) % 3, so the blocks need no shuffles and the lanes are folded
+ * back into x, y and z once at the end.
+ */
+static void ReduceBounds(const float* min_lanes, const float* max_lanes, int num_lanes, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    float* dst_min = &min.x;
+    float* dst_max = &max.x;
+    for (int i = 0; i < num_lanes; i++)
+    {
+        dst_min[i % 3] = std::min(dst_min[i % 3], min_lanes[i]);
+        dst_max[i % 3] = std::max(dst_max[i % 3], max_lanes[i]);
+    }
+}
+
+static void ComputeBoundsScalar(const uint8_t* positions, size_t count, size_t stride, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        SDLx_ModelVec3 position;
+        std::memcpy(&position, positions + i * stride, sizeof(position));
+        min.x = std::min(min.x, position.x);
+        min.y = std::min(min.y, position.y);
+        min.z = std::min(min.z, position.z);
+        max.x = std::max(max.x, position.x);
+        max.y = std::max(max.y, position.y);
+        max.z = std::max(max.z, position.z);
+    }
+}
+
+#if SDLX_MODEL_SSE
+SDLX_MODEL_TARGET_AVX2 static size_t ComputeBoundsAVX2(const float* positions, size_t count, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    __m256 min_lanes[3] = {_mm256_set1_ps(FLT_MAX), _mm256_set1_ps(FLT_MAX), _mm256_set1_ps(FLT_MAX)};
+    __m256 max_lanes[3] = {_mm256_set1_ps(-FLT_MAX), _mm256_set1_ps(-FLT_MAX), _mm256_set1_ps(-FLT_MAX)};
+    size_t num_blocks = count / 8;
+    for (size_t i = 0; i < num_blocks; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            __m256 value = _mm256_loadu_ps(positions + i * 24 + j * 8);
+            min_lanes[j] = _mm256_min_ps(min_lanes[j], value);
+            max_lanes[j] = _mm256_max_ps(max_lanes[j], value);
+        }
+    }
+    float dst_min[24];
+    float dst_max[24];
+    for (int j = 0; j < 3; j++)
+    {
+        _mm256_storeu_ps(dst_min + j * 8, min_lanes[j]);
+        _mm256_storeu_ps(dst_max + j * 8, max_lanes[j]);
+    }
+    ReduceBounds(dst_min, dst_max, 24, min, max);
+    return num_blocks * 8;
+}
+
+static size_t ComputeBoundsSSE(const float* positions, size_t count, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    __m128 min_lanes[3] = {_mm_set1_ps(FLT_MAX), _mm_set1_ps(FLT_MAX), _mm_set1_ps(FLT_MAX)};
+    __m128 max_lanes[3] = {_mm_set1_ps(-FLT_MAX), _mm_set1_ps(-FLT_MAX), _mm_set1_ps(-FLT_MAX)};
+    size_t num_blocks = count / 4;
+    for (size_t i = 0; i < num_blocks; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            __m128 value = _mm_loadu_ps(positions + i * 12 + j * 4);
+            min_lanes[j] = _mm_min_ps(min_lanes[j], value);
+            max_lanes[j] = _mm_max_ps(max_lanes[j], value);
+        }
+    }
+    float dst_min[12];
+    float dst_max[12];
+    for (int j = 0; j < 3; j++)
+    {
+        _mm_storeu_ps(dst_min + j * 4, min_lanes[j]);
+        _mm_storeu_ps(dst_max + j * 4, max_lanes[j]);
+    }
+    ReduceBounds(dst_min, dst_max, 12, min, max);
+    return num_blocks * 4;
+}
+
+static size_t ComputeBoundsStridedSSE(const uint8_t* positions, size_t count, size_t stride, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    /* positions lead elements of at least 16 bytes so the fourth lane stays inside them */
+    __m128 min_lanes = _mm_set1_ps(FLT_MAX);
+    __m128 max_lanes = _mm_set1_ps(-FLT_MAX);
+    for (size_t i = 0; i < count; i++)
+    {
+        __m128 value = _mm_loadu_ps(reinterpret_cast<const float*>(positions + i * stride));
+        min_lanes = _mm_min_ps(min_lanes, value);
+        max_lanes = _mm_max_ps(max_lanes, value);
+    }
+    float dst_min[4];
+    float dst_max[4];
+    _mm_storeu_ps(dst_min, min_lanes);
+    _mm_storeu_ps(dst_max, max_lanes);
+    ReduceBounds(dst_min, dst_max, 3, min, max);
+    return count;
+}
+#elif SDLX_MODEL_NEON
+static size_t ComputeBoundsNEON(const float* positions, size_t count, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    float32x4_t min_lanes[3] = {vdupq_n_f32(FLT_MAX), vdupq_n_f32(FLT_MAX), vdupq_n_f32(FLT_MAX)};
+    float32x4_t max_lanes[3] = {vdupq_n_f32(-FLT_MAX), vdupq_n_f32(-FLT_MAX), vdupq_n_f32(-FLT_MAX)};
+    size_t num_blocks = count / 4;
+    for (size_t i = 0; i < num_blocks; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            float32x4_t value = vld1q_f32(positions + i * 12 + j * 4);
+            min_lanes[j] = vminq_f32(min_lanes[j], value);
+            max_lanes[j] = vmaxq_f32(max_lanes[j], value);
+        }
+    }
+    float dst_min[12];
+    float dst_max[12];
+    for (int j = 0; j < 3; j++)
+    {
+        vst1q_f32(dst_min + j * 4, min_lanes[j]);
+        vst1q_f32(dst_max + j * 4, max_lanes[j]);
+    }
+    ReduceBounds(dst_min, dst_max, 12, min, max);
+    return num_blocks * 4;
+}
+
+static size_t ComputeBoundsStridedNEON(const uint8_t* positions, size_t count, size_t stride, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    float32x4_t min_lanes = vdupq_n_f32(FLT_MAX);
+    float32x4_t max_lanes = vdupq_n_f32(-FLT_MAX);
+    for (size_t i = 0; i < count; i++)
+    {
+        float32x4_t value = vld1q_f32(reinterpret_cast<const float*>(positions + i * stride));
+        min_lanes = vminq_f32(min_lanes, value);
+        max_lanes = vmaxq_f32(max_lanes, value);
+    }
+    float dst_min[4];
+    float dst_max[4];
+    vst1q_f32(dst_min, min_lanes);
+    vst1q_f32(dst_max, max_lanes);
+    ReduceBounds(dst_min, dst_max, 3, min, max);
+    return count;
+}
+#endif
+
+void ComputeBounds(const void* positions, size_t count, size_t stride, SDLx_ModelVec3& min, SDLx_ModelVec3& max)
+{
+    const uint8_t* src_data = static_cast<const uint8_t*>(positions);
+    size_t num_computed = 0;
+    if (stride == sizeof(SDLx_ModelVec3))
+    {
+#if SDLX_MODEL_SSE
+        static const bool HasAVX2 = SDL_HasAVX2();
+        if (HasAVX2)
+        {
+            num_computed = ComputeBoundsAVX2(static_cast<const float*>(positions), count, min, max);
+        }
+        else
+        {
+            num_computed = ComputeBoundsSSE(static_cast<const float*>(positions), count, min, max);
+        }
+#elif SDLX_MODEL_NEON
+        num_computed = ComputeBoundsNEON(static_cast<const float*>(positions), count, min, max);
+#endif
+    }
+    else if (stride >= 16)
+    {
+#if SDLX_MODEL_SSE
+        num_computed = ComputeBoundsStridedSSE(src_data, count, stride, min, max);
+#elif SDLX_MODEL_NEON
+        num_computed = ComputeBoundsStridedNEON(src_data, count, stride, min, max);
+#endif
+    }
+    ComputeBoundsScalar(src_data + num_computed * stride, count - num_computed, stride, min, max);
+}
+
+uint32_t ReserveStaging(Staging& staging, uint32_t size, uint32_t alignment, std::function<void(void*)> write)
+{
+    uint32_t offset = (staging.size + alignment - 1) / alignment * alignment;
+    staging.size = offset + size;
+    staging.writes.emplace_back(offset, std::move(write));
+    return offset;
+}
+
+bool FlushStaging(Staging& staging)
+{
+    if (!staging.size)
+    {
+        return true;
     }
-    SDL_GPUTexture* texture;
     SDL_GPUTransferBuffer* transfer_buffer;
+    uint32_t offset = 0;
+    uint8_t* data;
+    if (staging.uploader)
     {
-        SDL_GPUTextureCreateInfo info{};
-        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-        info.type = SDL_GPU_TEXTURETYPE_2D;
-        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-        info.width = width;
-        info.height = height;
-        info.layer_count_or_depth = 1;
-        info.num_levels = 1;
-        texture = SDL_CreateGPUTexture(device, &info);
-        if (!texture)
-        {
-            SDL_Log("Failed to create texture: %s, %s", path.string().data(), SDL_GetError());
-            stbi_image_free(src_data);
-            return nullptr;
+        data = AllocateUploader(staging.uploader, staging.size, TextureAlignment, transfer_buffer, offset);
+        if (!data)
+        {
+            SDL_Log("Failed to allocate from uploader");
+            return false;
         }
     }
+    else
     {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = width * height * 4;
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
         {
-            SDL_Log("Failed to create transfer buffer: %s, %s", path.string().data(), SDL_GetError());
-            stbi_image_free(src_data);
-            SDL_ReleaseGPUTexture(device, texture);
+            SDL_GPUTransferBufferCreateInfo info{};
+            info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+            info.size = staging.size;
+            staging.transfer_buffer = SDL_CreateGPUTransferBuffer(staging.device, &info);
+            if (!staging.transfer_buffer)
+            {
+                SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+                return false;
+            }
+        }
+        transfer_buffer = staging.transfer_buffer;
+        data = static_cast<uint8_t*>(SDL_MapGPUTransferBuffer(staging.device, transfer_buffer, false));
+        if (!data)
+        {
+            SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+            return false;
+        }
+    }
+    for (const auto& [write_offset, write] : staging.writes)
+    {
+        write(data + write_offset);
+    }
+    if (!staging.uploader)
+    {
+        SDL_UnmapGPUTransferBuffer(staging.device, transfer_buffer);
+    }
+    staging.writes.clear();
+    for (auto& [location, region] : staging.buffer_uploads)
+    {
+        location.transfer_buffer = transfer_buffer;
+        location.offset += offset;
+    }
+    for (auto& [info, region] : staging.texture_uploads)
+    {
+        info.transfer_buffer = transfer_buffer;
+        info.offset += offset;
+    }
+    return true;
+}
+
+void RecordStaging(Model* model, Staging& staging, SDL_GPUCopyPass* copy_pass)
+{
+    for (const auto& [location, region] : staging.buffer_uploads)
+    {
+        SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
+    }
+    for (const auto& [info, region] : staging.texture_uploads)
+    {
+        SDL_UploadToGPUTexture(copy_pass, &info, &region, true);
+    }
+    PublishShared(model, staging.device, staging.shared);
+    ReleaseStaging(staging);
+}
+
+void ReleaseStaging(Staging& staging)
+{
+    SDL_ReleaseGPUTransferBuffer(staging.device, staging.transfer_buffer);
+    staging.transfer_buffer = nullptr;
+    staging.size = 0;
+    staging.writes.clear();
+    staging.buffer_uploads.clear();
+    staging.texture_uploads.clear();
+    staging.shared = {};
+}
+
+SDL_GPUBuffer* CreateBuffer(Staging& staging, SDL_GPUBufferUsageFlags usage, uint32_t size, std::function<void(void*)> write)
+{
+    SDL_GPUBuffer* buffer;
+    {
+        SDL_GPUBufferCreateInfo info{};
+        info.usage = usage;
+        info.size = size;
+        buffer = SDL_CreateGPUBuffer(staging.device, &info);
+        if (!buffer)
+        {
+            SDL_Log("Failed to create buffer: %s", SDL_GetError());
             return nullptr;
         }
     }
-    void* dst_data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
-    if (!dst_data)
+    SDL_GPUTransferBufferLocation location{};
+    SDL_GPUBufferRegion region{};
+    location.offset = ReserveStaging(staging, size, BufferAlignment, std::move(write));
+    region.buffer = buffer;
+    region.size = size;
+    staging.buffer_uploads.emplace_back(location, region);
+    return buffer;
+}
+
+SDL_GPUBuffer* CreateBuffer(Staging& staging, SDL_GPUBufferUsageFlags usage, const void* src_data, uint32_t size)
+{
+    return CreateBuffer(staging, usage, size, [src_data, size](void* dst_data)
     {
-        SDL_Log("Failed to map transfer buffer: %s, %s", path.string().data(), SDL_GetError());
-        stbi_image_free(src_data);
-        SDL_ReleaseGPUTexture(device, texture);
+        std::memcpy(dst_data, src_data, size);
+    });
+}
+
+static SDL_GPUTexture* CreateTexture(Staging& staging, SDL_GPUTextureFormat format, uint32_t width, uint32_t height, uint32_t num_levels)
+{
+    SDL_GPUTextureCreateInfo info{};
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = format;
+    info.width = width;
+    info.height = height;
+    info.layer_count_or_depth = 1;
+    info.num_levels = num_levels;
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture(staging.device, &info);
+    if (!texture)
+    {
+        SDL_Log("Failed to create texture: %s", SDL_GetError());
         return nullptr;
     }
-    std::memcpy(dst_data, src_data, width * height * 4);
-    stbi_image_free(src_data);
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
+    return texture;
+}
+
+static void UploadTexture(Staging& staging, SDL_GPUTexture* texture, uint32_t level, uint32_t width, uint32_t height, uint32_t size, std::function<void(void*)> write)
+{
     SDL_GPUTextureTransferInfo info{};
     SDL_GPUTextureRegion region{};
-    info.transfer_buffer = transfer_buffer;
+    info.offset = ReserveStaging(staging, size, TextureAlignment, std::move(write));
     region.texture = texture;
+    region.mip_level = level;
     region.w = width;
     region.h = height;
     region.d = 1;
-    SDL_UploadToGPUTexture(copy_pass, &info, &region, true);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
-    return texture;
+    staging.texture_uploads.emplace_back(info, region);
 }
 
-SDL_GPUTexture* Create1x1Texture(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, uint32_t color)
+bool IsTextureSupported(SDL_GPUDevice* device, const SDLx_ModelImage& image)
 {
-    SDL_GPUTexture* texture;
-    SDL_GPUTransferBuffer* transfer_buffer;
+    return image.format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM || CanDecompress(image.format) ||
+        SDL_GPUTextureSupportsFormat(device, image.format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER);
+}
+
+static SDL_GPUTextureFormat GetTextureFormat(SDL_GPUDevice* device, SDL_GPUTextureFormat format)
+{
+    /* block formats the device can't sample are transcoded to the best one it can, or to RGBA8 */
+    static const SDL_GPUTextureFormat Formats[] =
     {
-        SDL_GPUTextureCreateInfo info{};
-        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-        info.type = SDL_GPU_TEXTURETYPE_2D;
-        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-        info.width = 1;
-        info.height = 1;
-        info.layer_count_or_depth = 1;
-        info.num_levels = 1;
-        texture = SDL_CreateGPUTexture(device, &info);
-        if (!texture)
-        {
-            SDL_Log("Failed to create 1x1 texture: %s", SDL_GetError());
-            return nullptr;
-        }
+        SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM,
+        SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM,
+        SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM,
+    };
+    if (format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM ||
+        SDL_GPUTextureSupportsFormat(device, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER))
+    {
+        return format;
     }
+    for (SDL_GPUTextureFormat candidate : Formats)
     {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = 4;
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
+        if (SDL_GPUTextureSupportsFormat(device, candidate, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER))
         {
-            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
-            SDL_ReleaseGPUTexture(device, texture);
-            return nullptr;
+            return candidate;
         }
     }
-    void* data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
-    if (!data)
+    return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+}
+
+SDL_GPUTexture* CreateTexture(Staging& staging, const SDLx_ModelImage& image)
+{
+    SDL_GPUTextureFormat format = GetTextureFormat(staging.device, image.format);
+    uint32_t num_levels = std::max(image.num_levels, 1);
+    SDL_GPUTexture* texture = CreateTexture(staging, format, image.width, image.height, num_levels);
+    if (!texture)
     {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
-        SDL_ReleaseGPUTexture(device, texture);
-        SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
         return nullptr;
     }
-    std::memcpy(data, &color, 4);
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
-    SDL_GPUTextureTransferInfo info{};
-    SDL_GPUTextureRegion region{};
-    info.transfer_buffer = transfer_buffer;
-    region.texture = texture;
-    region.w = 1;
-    region.h = 1;
-    region.d = 1;
-    SDL_UploadToGPUTexture(copy_pass, &info, &region, true);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    /* each level gets its own aligned placement and is transcoded straight into staging */
+    const uint8_t* pixels = static_cast<const uint8_t*>(image.pixels);
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        uint32_t src_size = SDL_CalculateGPUTextureFormatSize(image.format, width, height, 1);
+        uint32_t dst_size = SDL_CalculateGPUTextureFormatSize(format, width, height, 1);
+        UploadTexture(staging, texture, level, width, height, dst_size,
+            [src_format = image.format, format, pixels, width, height, src_size](void* dst_data)
+        {
+            if (src_format == format)
+            {
+                std::memcpy(dst_data, pixels, src_size);
+            }
+            else if (format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM)
+            {
+                Decompress(src_format, pixels, width, height, static_cast<uint8_t*>(dst_data));
+            }
+            else
+            {
+                std::vector<uint8_t> texels(width * height * 4);
+                Decompress(src_format, pixels, width, height, texels.data());
+                Compress(format, texels.data(), width, height, static_cast<uint8_t*>(dst_data));
+            }
+        });
+        pixels += src_size;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
     return texture;
 }
 
-SDL_GPUBuffer* CreateCubeVertexBuffer(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass)
+SDL_GPUTexture* AcquireStagedTexture(Model* model, Staging& staging, const std::string& key)
 {
-    static const SDLx_ModelVec3 Vertices[8] =
+    SDL_GPUTexture* texture = AcquireSharedTexture(staging.device, key);
+    if (texture)
     {
-       {0.0f, 0.0f, 1.0f},
-       {1.0f, 0.0f, 1.0f},
-       {1.0f, 1.0f, 1.0f},
-       {0.0f, 1.0f, 1.0f},
-       {0.0f, 0.0f, 0.0f},
-       {1.0f, 0.0f, 0.0f},
-       {1.0f, 1.0f, 0.0f},
-       {0.0f, 1.0f, 0.0f},
-    };
-    SDL_GPUTransferBuffer* transfer_buffer;
-    SDL_GPUBuffer* buffer;
+        model->shared_textures.push_back(texture);
+        return texture;
+    }
+    /* staged earlier by this load and already owned by the model */
+    for (const auto& [staged_key, staged_texture] : staging.shared.textures)
     {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = sizeof(Vertices);
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
+        if (staged_key == key)
         {
-            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
-            return nullptr;
+            return staged_texture;
         }
     }
+    return nullptr;
+}
+
+void StageSharedTexture(Model* model, Staging& staging, const std::string& key, SDL_GPUTexture* texture)
+{
+    /* private until its upload is recorded, so no other model can sample it empty */
+    model->textures.push_back(texture);
+    staging.shared.textures.emplace_back(key, texture);
+}
+
+void PublishShared(Model* model, SDL_GPUDevice* device, const SharedResources& shared)
+{
+    /* a resource that lost the race to another load stays private to this model */
+    for (const auto& [key, texture] : shared.textures)
     {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-        info.size = sizeof(Vertices);
-        buffer = SDL_CreateGPUBuffer(device, &info);
-        if (!buffer)
+        if (ShareTexture(device, key, texture))
         {
-            SDL_Log("Failed to create buffer: %s", SDL_GetError());
-            return nullptr;
+            std::erase(model->textures, texture);
+            model->shared_textures.push_back(texture);
         }
     }
-    void* vertex_data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
-    if (!vertex_data)
+    for (const auto& [key, buffer] : shared.buffers)
+    {
+        if (ShareBuffer(device, key, buffer))
+        {
+            std::erase(model->buffers, buffer);
+            model->shared_buffers.push_back(buffer);
+        }
+    }
+}
+
+SDL_GPUTexture* AcquireDefaultTexture(Model* model, Staging& staging, uint32_t color)
+{
+    char key[32];
+    SDL_snprintf(key, sizeof(key), "1x1:%08x", color);
+    SDL_GPUTexture* texture = AcquireStagedTexture(model, staging, key);
+    if (texture)
+    {
+        return texture;
+    }
+    texture = CreateTexture(staging, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, 1, 1, 1);
+    if (!texture)
     {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
         return nullptr;
     }
-    std::memcpy(vertex_data, Vertices, sizeof(Vertices));
-    SDL_GPUTransferBufferLocation location{};
-    SDL_GPUBufferRegion region{};
-    location.transfer_buffer = transfer_buffer;
-    region.buffer = buffer;
-    region.size = sizeof(Vertices);
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    UploadTexture(staging, texture, 0, 1, 1, 4, [color](void* dst_data)
+    {
+        std::memcpy(dst_data, &color, 4);
+    });
+    StageSharedTexture(model, staging, key, texture);
+    return texture;
+}
+
+static SDL_GPUBuffer* AcquireBuffer(Model* model, Staging& staging, const char* key,
+    SDL_GPUBufferUsageFlags usage, const void* src_data, uint32_t size)
+{
+    SDL_GPUBuffer* buffer = AcquireSharedBuffer(staging.device, key);
+    if (buffer)
+    {
+        model->shared_buffers.push_back(buffer);
+        return buffer;
+    }
+    buffer = CreateBuffer(staging, usage, src_data, size);
+    if (!buffer)
+    {
+        return nullptr;
+    }
+    /* like textures, shared once the copy is recorded */
+    model->buffers.push_back(buffer);
+    staging.shared.buffers.emplace_back(key, buffer);
     return buffer;
 }
 
-SDL_GPUBuffer* CreateCubeIndexBuffer(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass)
+SDL_GPUBuffer* AcquireCubeVertexBuffer(Model* model, Staging& staging)
+{
+    static const SDLx_ModelVec3 Vertices[8] =
+    {
+       {0.0f, 0.0f, 1.0f},
+       {1.0f, 0.0f, 1.0f},
+       {1.0f, 1.0f, 1.0f},
+       {0.0f, 1.0f, 1.0f},
+       {0.0f, 0.0f, 0.0f},
+       {1.0f, 0.0f, 0.0f},
+       {1.0f, 1.0f, 0.0f},
+       {0.0f, 1.0f, 0.0f},
+    };
+    return AcquireBuffer(model, staging, "cube:vertex", SDL_GPU_BUFFERUSAGE_VERTEX, Vertices, sizeof(Vertices));
+}
+
+SDL_GPUBuffer* AcquireCubeIndexBuffer(Model* model, Staging& staging)
 {
     static const uint16_t Indices[36] =
     {
@@ -201,44 +782,5 @@ SDL_GPUBuffer* CreateCubeIndexBuffer(SDL_GPUDevice* device, SDL_GPUCopyPass* cop
         4, 5, 1,
         4, 1, 0,
     };
-    SDL_GPUTransferBuffer* transfer_buffer;
-    SDL_GPUBuffer* buffer;
-    {
-        SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = sizeof(Indices);
-        transfer_buffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transfer_buffer)
-        {
-            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
-            return nullptr;
-        }
-    }
-    {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-        info.size = sizeof(Indices);
-        buffer = SDL_CreateGPUBuffer(device, &info);
-        if (!buffer)
-        {
-            SDL_Log("Failed to create buffer: %s", SDL_GetError());
-            return nullptr;
-        }
-    }
-    void* index_data = SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
-    if (!index_data)
-    {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
-        return nullptr;
-    }
-    std::memcpy(index_data, Indices, sizeof(Indices));
-    SDL_GPUTransferBufferLocation location{};
-    SDL_GPUBufferRegion region{};
-    location.transfer_buffer = transfer_buffer;
-    region.buffer = buffer;
-    region.size = sizeof(Indices);
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
-    return buffer;
+    return AcquireBuffer(model, staging, "cube:index", SDL_GPU_BUFFERUSAGE_INDEX, Indices, sizeof(Indices));
 }
\ No newline at end of file
@@ -3,14 +3,178 @@
 #include <SDL3/SDL.h>
 #include <SDLx_model/SDL_model.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
 
-bool LoadGltf(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, std::filesystem::path& path);
-bool LoadVoxObj(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, std::filesystem::path& path);
-bool LoadVoxRaw(SDLx_Model* model, SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, std::filesystem::path& path);
-SDL_GPUTexture* LoadTexture(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, const std::filesystem::path& path);
-SDL_GPUTexture* Create1x1Texture(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, uint32_t color);
-SDL_GPUTexture* Create1x1Texture(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, uint32_t color);
-SDL_GPUBuffer* CreateCubeVertexBuffer(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass);
-SDL_GPUBuffer* CreateCubeIndexBuffer(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass);
\ No newline at end of file
+struct Data : SDLx_ModelData
+{
+    ~Data();
+
+    SDL_GPUDevice* device;
+    std::vector<SDLx_ModelMeshData> meshes;
+    std::vector<SDLx_ModelPrimitiveData> primitives;
+    std::vector<SDLx_ModelNodeData> nodes;
+    std::vector<SDLx_ModelVoxRawShape> vox_shapes;
+    std::vector<SDLx_ModelVoxRawNodeData> vox_nodes;
+    std::vector<SDLx_ModelVoxOctree> vox_octrees;
+    std::vector<SDLx_ModelImage> images;
+    std::vector<std::string> image_keys;
+    std::vector<SDL_GPUTexture*> image_textures;
+    std::vector<std::unique_ptr<void, void(*)(void*)>> allocations;
+    std::vector<std::span<const uint8_t>> mappings;
+
+    template<typename T>
+    T* Allocate(size_t count)
+    {
+        T* data = static_cast<T*>(SDL_malloc(count * sizeof(T)));
+        if (data)
+        {
+            allocations.emplace_back(data, SDL_free);
+        }
+        return data;
+    }
+};
+
+struct Model : SDLx_Model
+{
+    std::vector<SDLx_ModelMesh> meshes;
+    std::vector<SDLx_ModelPrimitive> primitives;
+    std::vector<SDLx_ModelNode> nodes;
+    std::vector<SDLx_ModelMeshlet> meshlets;
+    std::vector<SDLx_ModelVoxRawShape> vox_shapes;
+    std::vector<SDLx_ModelVoxRawNode> vox_nodes;
+    std::vector<SDLx_ModelVoxOctree> vox_octrees;
+    std::vector<SDLx_ModelVoxOctreeNode> vox_octree_nodes;
+    std::vector<SDLx_ModelVoxOctreeBrick> vox_octree_bricks;
+    std::vector<SDL_GPUBuffer*> buffers;
+    std::vector<SDL_GPUTexture*> textures;
+    std::vector<SDL_GPUBuffer*> shared_buffers;
+    std::vector<SDL_GPUTexture*> shared_textures;
+};
+
+struct VoxVoxel
+{
+    uint8_t x;
+    uint8_t y;
+    uint8_t z;
+    uint8_t palette_index;
+};
+
+struct VoxModel
+{
+    uint32_t size_x;
+    uint32_t size_y;
+    uint32_t size_z;
+    std::span<const VoxVoxel> voxels;
+};
+
+/* a shape reference of the scene graph, in the z up voxel space */
+struct VoxNode
+{
+    int model;             /* index into models */
+    int rotation[3][3];    /* applied around the model center, size / 2 */
+    int translation[3];
+};
+
+struct Vox
+{
+    std::vector<VoxModel> models;
+    std::vector<VoxNode> nodes;    /* one identity node per model without nTRN/nGRP/nSHP */
+    std::vector<uint32_t> palette; /* rgba bytes, indexed by palette_index */
+};
+
+struct VertexCacheStats
+{
+    uint64_t num_triangles;
+    uint64_t num_vertices;
+    uint64_t num_transforms;
+
+    void Analyze(std::span<const uint32_t> indices, uint32_t num_vertices);
+    void Add(const VertexCacheStats& other);
+    SDLx_ModelIndexStats Get() const;
+};
+
+/* resources created by a load, shared with other models once their uploads are recorded */
+struct SharedResources
+{
+    std::vector<std::pair<std::string, SDL_GPUTexture*>> textures;
+    std::vector<std::pair<std::string, SDL_GPUBuffer*>> buffers;
+};
+
+static constexpr uint32_t BufferAlignment = 16;
+static constexpr uint32_t TextureAlignment = 512;
+
+struct Staging
+{
+    SDL_GPUDevice* device;
+    SDLx_ModelUploader* uploader;
+    SDL_GPUTransferBuffer* transfer_buffer;
+    uint32_t size;
+    std::vector<std::pair<uint32_t, std::function<void(void*)>>> writes;
+    std::vector<std::pair<SDL_GPUTransferBufferLocation, SDL_GPUBufferRegion>> buffer_uploads;
+    std::vector<std::pair<SDL_GPUTextureTransferInfo, SDL_GPUTextureRegion>> texture_uploads;
+    SharedResources shared;
+};
+
+Data* DecodeModel(SDL_GPUDevice* device, const char* path, SDLx_ModelType type, SDLx_ModelFlags flags);
+bool HashGltf(Data* data, const std::filesystem::path& path, uint64_t& hash);
+bool ReadCache(Data* data, const std::filesystem::path& path, SDLx_ModelType type, const uint64_t* source_hash);
+bool WriteCache(const Data* data, const std::filesystem::path& path, uint64_t source_hash);
+bool DecodeGltf(Data* data, std::filesystem::path& path);
+bool DecodeVoxObj(Data* data, std::filesystem::path& path);
+bool DecodeVoxRaw(Data* data, std::filesystem::path& path);
+bool DecodeVoxGreedy(Data* data, std::filesystem::path& path);
+bool ParseVox(Data* data, std::filesystem::path& path, Vox& vox);
+void BuildVoxOctree(const VoxModel& model, std::vector<SDLx_ModelVoxOctreeNode>& nodes, std::vector<SDLx_ModelVoxOctreeBrick>& bricks, int& depth);
+bool GenerateLods(SDLx_ModelPrimitiveData& primitive, std::vector<uint32_t>& indices);
+void OptimizeIndices(std::span<uint32_t> indices, const SDLx_ModelVec3* positions, uint32_t num_vertices);
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t num_vertices);
+void BuildMeshlets(const SDLx_ModelPrimitiveData& primitive, std::vector<SDLx_ModelMeshlet>& meshlets, std::vector<uint32_t>& vertices, std::vector<uint32_t>& triangles);
+bool UploadGltf(Model* model, Staging& staging, const SDLx_ModelData* data);
+bool UploadVoxObj(Model* model, Staging& staging, const SDLx_ModelData* data);
+bool UploadVoxRaw(Model* model, Staging& staging, const SDLx_ModelData* data);
+std::span<const uint8_t> MapFile(Data* data, const std::filesystem::path& path);
+void UnmapFile(std::span<const uint8_t> file);
+void ComputeBounds(const void* positions, size_t count, size_t stride, SDLx_ModelVec3& min, SDLx_ModelVec3& max);
+uint64_t Hash(std::span<const uint8_t> bytes);
+uint64_t Hash(uint64_t hash, std::span<const uint8_t> bytes);
+bool DecodeImage(const std::filesystem::path& path, SDLx_ModelImage& image);
+bool DecodeImage(std::span<const uint8_t> file, SDLx_ModelImage& image);
+bool GenerateMipmaps(SDLx_ModelImage& image);
+bool DecodeKtx2(std::span<const uint8_t> file, SDLx_ModelImage& image);
+bool DecodeBasisLz(std::span<const uint8_t> global_data, std::span<const std::span<const uint8_t>> levels, uint32_t width, uint32_t height, bool flip, SDLx_ModelImage& image);
+bool CanDecompress(SDL_GPUTextureFormat format);
+void Decompress(SDL_GPUTextureFormat format, const uint8_t* src_data, uint32_t width, uint32_t height, uint8_t* dst_data);
+bool CanCompress(SDL_GPUTextureFormat format);
+void Compress(SDL_GPUTextureFormat format, const uint8_t* src_data, uint32_t width, uint32_t height, uint8_t* dst_data);
+void FreeImage(void* pixels);
+void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+Model* StageModel(Staging& staging, const SDLx_ModelData* data);
+uint8_t* AllocateUploader(SDLx_ModelUploader* uploader, uint32_t size, uint32_t alignment, SDL_GPUTransferBuffer*& transfer_buffer, uint32_t& offset);
+bool FlushStaging(Staging& staging);
+void RecordStaging(Model* model, Staging& staging, SDL_GPUCopyPass* copy_pass);
+void ReleaseStaging(Staging& staging);
+uint32_t ReserveStaging(Staging& staging, uint32_t size, uint32_t alignment, std::function<void(void*)> write);
+SDL_GPUBuffer* CreateBuffer(Staging& staging, SDL_GPUBufferUsageFlags usage, uint32_t size, std::function<void(void*)> write);
+SDL_GPUBuffer* CreateBuffer(Staging& staging, SDL_GPUBufferUsageFlags usage, const void* src_data, uint32_t size);
+SDL_GPUTexture* AcquireSharedTexture(SDL_GPUDevice* device, const std::string& key);
+bool ShareTexture(SDL_GPUDevice* device, const std::string& key, SDL_GPUTexture* texture);
+void ReleaseSharedTexture(SDL_GPUDevice* device, SDL_GPUTexture* texture);
+SDL_GPUBuffer* AcquireSharedBuffer(SDL_GPUDevice* device, const std::string& key);
+bool ShareBuffer(SDL_GPUDevice* device, const std::string& key, SDL_GPUBuffer* buffer);
+void ReleaseSharedBuffer(SDL_GPUDevice* device, SDL_GPUBuffer* buffer);
+bool IsTextureSupported(SDL_GPUDevice* device, const SDLx_ModelImage& image);
+SDL_GPUTexture* CreateTexture(Staging& staging, const SDLx_ModelImage& image);
+SDL_GPUTexture* AcquireDefaultTexture(Model* model, Staging& staging, uint32_t color);
+SDL_GPUTexture* AcquireStagedTexture(Model* model, Staging& staging, const std::string& key);
+void StageSharedTexture(Model* model, Staging& staging, const std::string& key, SDL_GPUTexture* texture);
+void PublishShared(Model* model, SDL_GPUDevice* device, const SharedResources& shared);
+SDL_GPUBuffer* AcquireCubeVertexBuffer(Model* model, Staging& staging);
+SDL_GPUBuffer* AcquireCubeIndexBuffer(Model* model, Staging& staging);
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <SDL3/SDL.h>
+#include <SDLx_model/SDL_model.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/*
+ * Converts every model under the given files or directories to <path>.sdlxm.
+ * Runs headless: decoding makes no GPU calls. A cache whose sources are
+ * unchanged is validated and left untouched, so reruns only rewrite what
+ * changed. The flags are part of the cache key, so they must match the
+ * loads: -m MIPMAPS, -g GREEDY, -c CULL, -t OCTREE, -l LODS, -s MESHLETS and
+ * -o OPTIMIZE. With -o, the vertex cache statistics of each model are logged.
+ *
+ * sdlxm_convert [-j <workers>] [-m] [-g] [-c] [-t] [-l] [-s] [-o] <path>...
+ */
+
+/* MagicaVoxel obj exports are found through their .vox */
+static bool IsSource(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+    {
+        return std::tolower(c);
+    });
+    return extension == ".gltf" || extension == ".glb" || extension == ".vox";
+}
+
+static void AddModels(const std::filesystem::path& path, std::set<std::filesystem::path>& models)
+{
+    std::error_code error;
+    if (std::filesystem::is_directory(path, error))
+    {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path, error))
+        {
+            if (entry.is_regular_file(error) && IsSource(entry.path()))
+            {
+                models.insert(std::filesystem::path(entry.path()).replace_extension());
+            }
+        }
+    }
+    else if (IsSource(path))
+    {
+        models.insert(std::filesystem::path(path).replace_extension());
+    }
+    else
+    {
+        SDL_Log("Skipping unknown file: %s", path.string().data());
+    }
+}
+
+static std::filesystem::file_time_type GetWriteTime(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : time;
+}
+
+int main(int argc, char** argv)
+{
+    SDL_SetLogPriorities(SDL_LOG_PRIORITY_VERBOSE);
+    int num_workers = std::max(1u, std::thread::hardware_concurrency());
+    SDLx_ModelFlags flags = SDLX_MODELFLAG_CACHE;
+    std::set<std::filesystem::path> unique_models;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc)
+        {
+            num_workers = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-m")
+        {
+            flags |= SDLX_MODELFLAG_MIPMAPS;
+        }
+        else if (arg == "-g")
+        {
+            flags |= SDLX_MODELFLAG_GREEDY;
+        }
+        else if (arg == "-c")
+        {
+            flags |= SDLX_MODELFLAG_CULL;
+        }
+        else if (arg == "-t")
+        {
+            flags |= SDLX_MODELFLAG_OCTREE;
+        }
+        else if (arg == "-l")
+        {
+            flags |= SDLX_MODELFLAG_LODS;
+        }
+        else if (arg == "-s")
+        {
+            flags |= SDLX_MODELFLAG_MESHLETS;
+        }
+        else if (arg == "-o")
+        {
+            flags |= SDLX_MODELFLAG_OPTIMIZE;
+        }
+        else
+        {
+            AddModels(arg, unique_models);
+        }
+    }
+    if (unique_models.empty())
+    {
+        SDL_Log("Usage: sdlxm_convert [-j <workers>] [-m] [-g] [-c] [-t] [-l] [-s] [-o] <path>...");
+        return 1;
+    }
+    std::vector<std::filesystem::path> models(unique_models.begin(), unique_models.end());
+    std::atomic<size_t> next{};
+    std::atomic<int> num_converted{};
+    std::atomic<int> num_failed{};
+    auto work = [&]()
+    {
+        for (size_t i = next++; i < models.size(); i = next++)
+        {
+            std::filesystem::path cache = std::filesystem::path(models[i]).replace_extension(".sdlxm");
+            std::filesystem::file_time_type time = GetWriteTime(cache);
+            SDLx_ModelData* data = SDLx_ModelDecode(models[i].string().data(), SDLX_MODELTYPE_INVALID, flags);
+            if (!data)
+            {
+                SDL_Log("Failed to convert: %s", models[i].string().data());
+                num_failed++;
+                continue;
+            }
+            if (data->index_stats.acmr > 0.0f)
+            {
+                SDL_Log("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", models[i].string().data(),
+                    data->source_index_stats.acmr, data->index_stats.acmr, data->source_index_stats.atvr, data->index_stats.atvr);
+            }
+            SDLx_ModelDestroyData(data);
+            if (GetWriteTime(cache) != time)
+            {
+                SDL_Log("Converted: %s", cache.string().data());
+                num_converted++;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < std::min<int>(num_workers, models.size()); i++)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    SDL_Log("%d converted, %d up to date, %d failed", num_converted.load(),
+        int(models.size()) - num_converted.load() - num_failed.load(), num_failed.load());
+    return num_failed ? 1 : 0;
+}
@@ -4,6 +4,7 @@
 #include <SDLx_model/SDL_model.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include <algorithm>
 #include <cmath>
@@ -232,6 +233,9 @@ static void Draw()
                     vertex_buffers[0].buffer = primitive.position_buffer;
                     vertex_buffers[1].buffer = primitive.texcoord_buffer;
                     vertex_buffers[2].buffer = primitive.normal_buffer;
+                    vertex_buffers[0].offset = primitive.position_buffer_offset;
+                    vertex_buffers[1].offset = primitive.texcoord_buffer_offset;
+                    vertex_buffers[2].offset = primitive.normal_buffer_offset;
                     index_buffer.buffer = primitive.index_buffer;
                     textures[0].texture = primitive.color_texture;
                     textures[0].sampler = nearest_sampler;
@@ -240,7 +244,7 @@ static void Draw()
                     SDL_BindGPUVertexBuffers(render_pass, 0, vertex_buffers, 3);
                     SDL_BindGPUIndexBuffer(render_pass, &index_buffer, primitive.index_element_size);
                     SDL_BindGPUFragmentSamplers(render_pass, 0, textures, 2);
-                    SDL_DrawGPUIndexedPrimitives(render_pass, primitive.num_indices, 1, 0, 0, 0);
+                    SDL_DrawGPUIndexedPrimitives(render_pass, primitive.num_indices, 1, primitive.first_index, primitive.vertex_offset, 0);
                 }
             }
             break;
@@ -273,10 +277,15 @@ static void Draw()
             vertex_buffers[1].buffer = vox_raw.instance_buffer;
             index_buffer.buffer = vox_raw.index_buffer;
             SDL_BindGPUGraphicsPipeline(render_pass, pipelines[SDLX_MODELTYPE_VOXRAW]);
-            SDL_PushGPUVertexUniformData(command_buffer, 0, &view_proj_matrix, sizeof(view_proj_matrix));
             SDL_BindGPUVertexBuffers(render_pass, 0, vertex_buffers, 2);
             SDL_BindGPUIndexBuffer(render_pass, &index_buffer, vox_raw.index_element_size);
-            SDL_DrawGPUIndexedPrimitives(render_pass, vox_raw.num_indices, vox_raw.num_instances, 0, 0, 0);
+            for (int i = 0; i < vox_raw.num_nodes; i++)
+            {
+                SDLx_ModelVoxRawShape* shape = vox_raw.nodes[i].shape;
+                glm::mat4 matrix = view_proj_matrix * glm::make_mat4(vox_raw.nodes[i].transform);
+                SDL_PushGPUVertexUniformData(command_buffer, 0, &matrix, sizeof(matrix));
+                SDL_DrawGPUIndexedPrimitives(render_pass, vox_raw.num_indices, shape->num_instances, 0, 0, shape->first_instance);
+            }
         }
         break;
     }